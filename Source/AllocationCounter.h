@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    AllocationCounter.h
+    Created: 19 Oct 2026
+
+    Counts heap allocations made by the whole process. The counters are fed
+    by the replacement operator new in Main.cpp, which only costs one atomic
+    increment per allocation. It's only compiled in when the application is
+    built with GSI_COUNT_ALLOCATIONS=1, and then says so with setEnabled().
+    Until that happens isEnabled() is false and the counters read zero, so
+    a header that uses them without the replacement doesn't report zeros as
+    if they had been measured.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef GSI_COUNT_ALLOCATIONS
+ #define GSI_COUNT_ALLOCATIONS 0
+#endif
+
+//==============================================================================
+struct AllocationCounter
+{
+    static bool isEnabled() noexcept    { return getCounters().enabled.load(std::memory_order_relaxed); }
+
+    // Called at startup by the translation unit that has the replacement operator new
+    static void setEnabled() noexcept
+    {
+        getCounters().enabled.store(true, std::memory_order_relaxed);
+    }
+
+    static void add(size_t size) noexcept
+    {
+        getCounters().allocations.fetch_add(1, std::memory_order_relaxed);
+        getCounters().bytes.fetch_add((int64)size, std::memory_order_relaxed);
+    }
+
+    static int64 getNumAllocations() noexcept  { return getCounters().allocations.load(std::memory_order_relaxed); }
+    static int64 getNumBytes() noexcept        { return getCounters().bytes.load(std::memory_order_relaxed); }
+
+private:
+    struct Counters
+    {
+        std::atomic<int64> allocations { 0 }, bytes { 0 };
+        std::atomic<bool> enabled { false };
+    };
+
+    static Counters& getCounters() noexcept
+    {
+        static Counters counters;
+        return counters;
+    }
+};
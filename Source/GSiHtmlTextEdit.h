@@ -10,7 +10,9 @@
     easily format text with different sizes, colors, styles, fonts and also
     inserts hyperlinks with cursor change and a floating tooltip when the
     mouse pointer is over the links.
-    Of course this supports only some basic HTML4 tags, no CSS and no JS.
+    Of course this supports only some basic HTML4 tags and no JS. CSS is
+    limited to what a TextEditor can show: rules from <style> blocks or a
+    shared HtmlStyleSheet (see setStyleSheet()), and inline style attributes.
 
   ==============================================================================
 */
@@ -18,17 +20,20 @@
 #pragma once
 
 #include <JuceHeader.h>
-
-#if JUCE_WINDOWS && JUCE_MAJOR_VERSION >= 8 && JUCE8_USE_SOFTWARE_RENDERER // JUCE 8.0.0 or later
- #define IMAGE_FROM_DATA_SIZE SoftwareImageType().convert(ImageCache::getFromMemory(data, size))
-#else
- #define IMAGE_FROM_DATA_SIZE ImageCache::getFromMemory(data, size)
-#endif
+#include "StreamingPngWriter.h"
+#include "AllocationCounter.h"
+#include "TraceRecorder.h"
+#include "HtmlDocument.h"
+#include "HtmlStringView.h"
+#include "HtmlEntities.h"
+#include "HtmlStyleSheet.h"
+#include "HtmlResources.h"
+#include "HtmlThreadPool.h"
 
 
 //==============================================================================
 
-class GSiHtmlTextEdit : public juce::Component
+class GSiHtmlTextEdit : public juce::Component, private juce::Timer
 {
 public:
     GSiHtmlTextEdit()
@@ -54,14 +59,38 @@ public:
 
         // Used to catch mouse movement
         addMouseListener(this, true);
+
+        ++getNumInstances();
+    }
+
+    ~GSiHtmlTextEdit() override
+    {
+        // The last one turns off the lights
+        if (--getNumInstances() == 0)
+            clearTypefaceCache();
     }
 
     void Reset(bool fullReset = false)
     {
+        // Drop any page that is still being parsed progressively
+        stopTimer();
+        parser = ParserState();
+        progressiveSource.clear();
+        progressiveMappedFile.reset();
+        diskCacheToStore = nullptr;
+
+        // Other views may still be showing the previous document, it's left untouched
+        document = new HtmlDocument();
+        documentReleased = false;
+
+        sources.clear();
+        sourcesComplete = true;
+        trimLevel = 0;
+        preview = LivePreview();
+
         charCounter = 0; // Character count
         lastSearchEndIndex = 0;
         lastSearchString.clear();
-        AllLinks.clear();
         ImageComponents.clear();
 
         textEditor->clear();
@@ -70,36 +99,44 @@ public:
             textEditor->setBounds(textEditor->getBounds().withHeight(0));
 
         Comment = false;
+        styleStack.clear();
+        pageStyleSheet.clear();
 
         if (fullReset)
         {
-            fontFace = prev_fontFace = "Verdana";
-            fontSize = prev_fontSize = 18.f;
-            fontColor = prev_fontColor = Colours::white;
+            fontFace = "Verdana";
+            fontSize = 18.f;
+            fontColor = Colours::white;
             fontStyle = Font::FontStyleFlags::plain;
             doSetFont();
-            textEditor->setColour(TextEditor::ColourIds::textColourId, fontColor);
+            setTextColour(fontColor);
             //textEditor->setColour(TextEditor::ColourIds::backgroundColourId, Colours::black);
         }
+        else
+        {
+            // Start the document with the current style, so that it looks the same in other views
+            setEditorFont(textEditor->getFont());
+            setTextColour(textEditor->findColour(TextEditor::ColourIds::textColourId));
+        }
     }
 
     //==============================================================================
 
     void setNormalFontSize(float size)
     {
-        fontSize = prev_fontSize = size;
+        fontSize = size;
         doSetFont();
     }
 
     void setNormalFontColor(const Colour& col)
     {
-        fontColor = prev_fontColor = col;
-        textEditor->setColour(TextEditor::ColourIds::textColourId, fontColor);
+        fontColor = col;
+        setTextColour(fontColor);
     }
 
     void setNormalFontFace(const String& face)
     {
-        fontFace = prev_fontFace = face;
+        fontFace = face;
         doSetFont();
     }
 
@@ -172,496 +209,388 @@ public:
     // Parse and add some HTML to the TextEditor component
     void appendHtml(const String& HTML)
     {
-        bool beginTag = false, canParseTag = false;
-        bool beginEncoded = false, canParseEncoding = false;
-        bool renderPreFormatted = false;
-        String tag, code, output;
-        juce_wchar lastChar = 0;
-        ImagesInThisDocument.clear();
+        recordSource({ File(), HTML, nullptr, 0 });
+        parseNow(HTML.toRawUTF8(), HTML.getNumBytesAsUTF8());
+    }
+
+    // Map an HTML file into memory and parse it in place, without loading a copy of it first
+    bool appendHtmlFromFile(const File& file)
+    {
+        MemoryMappedFile mappedFile(file, MemoryMappedFile::readOnly);
+        if (mappedFile.getData() == nullptr) return false;
 
-        // Replace CRLF with just LF
-        String input = HTML.replace("\r\n", "\n");
+        recordSource({ file, String(), nullptr, 0 });
+        parseNow(static_cast<const char*>(mappedFile.getData()), mappedFile.getSize());
+        return true;
+    }
 
-        // Parse each single character in the HTML text
-        for (auto s : input)
+    // Parse a raw UTF-8 buffer (e.g. straight from BinaryData or a memory-mapped file).
+    // The buffer is only read, never copied, and it doesn't need to be null-terminated.
+    // Set bufferIsPermanent if the buffer outlives this component (BinaryData does), so that
+    // trimMemory() can drop the whole text and parse the buffer again when it's needed.
+    void appendHtml(const char* utf8, size_t numBytes, bool bufferIsPermanent = false)
+    {
+        recordSource(bufferIsPermanent ? SourceChunk { File(), String(), utf8, numBytes } : SourceChunk());
+        parseNow(utf8, numBytes);
+    }
+
+    //==============================================================================
+    // Progressive loading: the first screen of text is rendered right away, the rest of the page
+    // is parsed in small time slices on the message thread, so a big page shows up immediately.
+
+    void appendHtmlProgressively(const String& HTML)
+    {
+        completePendingParsing();
+        recordSource({ File(), HTML, nullptr, 0 });
+        progressiveSource = HTML;
+        startProgressiveParsing(progressiveSource.toRawUTF8(), progressiveSource.getNumBytesAsUTF8());
+    }
+
+    bool appendHtmlFromFileProgressively(const File& file)
+    {
+        completePendingParsing();
+        restoreMemory(); // Before mapping the file, rebuilding a trimmed page would unmap it
+        progressiveMappedFile.reset(new MemoryMappedFile(file, MemoryMappedFile::readOnly));
+        if (progressiveMappedFile->getData() == nullptr)
         {
-            // Make sure that content in a pre-formatted paragraph passes unaltered, including HTML code, until the closing tag
-            if (renderPreFormatted)
-            {
-                // Make a tab with 4 spaces
-                if (s == '\t')
-                {
-                    output += "   ";
-                    charCounter += 4;
-                }
-                else
-                {
-                    output += String::charToString(s);
-                    charCounter++;
-                }
+            progressiveMappedFile.reset();
+            return false;
+        }
 
-                if (output.endsWithIgnoreCase("</pre>"))
-                {
-                    output = output.replace("</pre>", "", true);
-                    charCounter -= 6;
+        recordSource({ file, String(), nullptr, 0 });
+        startProgressiveParsing(static_cast<const char*>(progressiveMappedFile->getData()), progressiveMappedFile->getSize());
+        return true;
+    }
 
-                    textEditor->setCaretPosition(charCounter);
-                    textEditor->insertTextAtCaret(output);
-                    output.clear();
+    // Show an HTML file, replacing the page. If the file was parsed before and hasn't changed since,
+    // the document saved in the cache is shown without parsing anything. Otherwise the file is
+    // parsed progressively, and the document is saved in the cache once complete.
+    bool loadHtmlFileWithCache(const File& file, HtmlDocumentDiskCache& cache)
+    {
+        auto settings = getParserSettingsSignature();
 
-                    renderPreFormatted = false;
-                    tag = "/pre";
-                    canParseTag = true;
-                }
-                continue;
-            }
+        auto cached = cache.find(file, settings, [this](const String& face, float height, int styleFlags)
+        {
+            return makeFont(face, height, styleFlags);
+        });
 
-            // Skip white spaces at the beginning of the text
-            else
-            {
-                if (s == '\t')
-                    continue;
-            }
+        if (cached != nullptr)
+        {
+            setDocument(cached);
+            return true;
+        }
 
-            // Catch HTML tag opening
-            if (s == '<')
-            {
-                textEditor->setCaretPosition(charCounter);
-                textEditor->insertTextAtCaret(output);
-                output.clear();
+        Reset();
 
-                beginTag = true;
-                canParseTag = false;
-                continue;
-            }
+        // Set before parsing, a small page is complete right away
+        diskCacheToStore = &cache;
+        fileToStore = file;
+        settingsToStore = settings;
 
-            // Read HTML tag or catch its closing
-            if (beginTag)
-            {
-                if (s == '>')
-                {
-                    if (Comment) { if (!tag.endsWith("--")) continue; else Comment = false; } // Discard everything within a comment including tags
-                    beginTag = false;
-                    canParseTag = true;
-                }
-                else
-                {
-                    tag += s;
-                    if (tag.startsWith("!--")) Comment = true; // Detect comment start
-                    continue;
-                }
-            }
+        if (appendHtmlFromFileProgressively(file))
+            return true;
 
-            // Catch HTML-Encoded character
-            if (s == '&')
-            {
-                // Add the text already rendered
-                textEditor->setCaretPosition(charCounter);
-                textEditor->insertTextAtCaret(output);
-                output.clear();
+        diskCacheToStore = nullptr;
+        return false;
+    }
 
-                beginEncoded = true;
-                canParseEncoding = false;
-                continue;
-            }
+    // The buffer must stay valid until parsing is complete (BinaryData resources always are),
+    // see appendHtml() about bufferIsPermanent
+    void appendHtmlProgressively(const char* utf8, size_t numBytes, bool bufferIsPermanent = false)
+    {
+        completePendingParsing();
+        recordSource(bufferIsPermanent ? SourceChunk { File(), String(), utf8, numBytes } : SourceChunk());
+        startProgressiveParsing(utf8, numBytes);
+    }
 
-            // Read HTML-Encoding or catch encoding closure
-            if (beginEncoded)
-            {
-                if (s == ';')
-                {
-                    beginEncoded = false;
-                    canParseEncoding = true;
-                }
-                else
-                {
-                    code += s;
-                    continue;
-                }
-            }
+    // Maximum time spent parsing on each timer tick while loading progressively
+    void setProgressiveTimeSlice(double milliseconds)
+    {
+        progressiveTimeSlice = jmax(0.5, milliseconds);
+    }
 
-            // Parse some common HTML-Encoded characters
-            if (canParseEncoding && code.isNotEmpty())
-            {
-                if (code == "nbsp")     textEditor->insertTextAtCaret(" ");     // Non-breakable space
-                if (code == "amp")      textEditor->insertTextAtCaret("&");     // Ampersand
-                if (code == "quot")     textEditor->insertTextAtCaret("\"");    // Quotation mark
-                if (code == "lt")       textEditor->insertTextAtCaret("<");
-                if (code == "rt")       textEditor->insertTextAtCaret(">");
-                if (code == "laquo")    textEditor->insertTextAtCaret(String::charToString(171));
-                if (code == "raquo")    textEditor->insertTextAtCaret(String::charToString(187));
-                if (code.startsWith("#")) textEditor->insertTextAtCaret(String::charToString(code.substring(1).getIntValue()));
+    // Pages of at least minimumBytes appended in one go (not progressively) are tokenized on numThreads
+    // threads, the TextEditor is still filled on this one. Only worth it for very big pages, like long logs.
+    // Zero turns it off, which is the default.
+    void setParallelParsing(size_t minimumBytes, int numThreads = SystemStats::getNumCpus())
+    {
+        parallelParsingThreshold = minimumBytes;
+        parallelParsingThreads = jmax(1, numThreads);
+    }
 
-                // A good solution would be to have a hash table with codes and their corresponding UNICODE characters...
+    bool isParsing() const
+    {
+        return parser.position != nullptr;
+    }
 
-                charCounter++;
-                code.clear();
-                continue;
-            }
+    // Parse whatever is left of a progressive load right now
+    void completePendingParsing()
+    {
+        if (!isParsing()) return;
 
-            // Parse Tags
-            if (canParseTag && tag.isNotEmpty())
-            {
-                //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-                // Break line
-                if (tag.startsWithIgnoreCase("br ") || tag == "br") { lastChar = '\n'; textEditor->insertTextAtCaret("\n"); charCounter++; }
+        stopTimer();
+        parseSlice(0.0, false);
+        finishParsing();
+    }
 
-                //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-                // Italic
-                else if (tag == "i" || tag == "em") { fontStyle |= Font::FontStyleFlags::italic;    doSetFont(); }
-                else if (tag == "/i" || tag == "/em") { fontStyle ^= Font::FontStyleFlags::italic;    doSetFont(); }
+    // Set a lambda that will be called when a page has been completely parsed
+    std::function<void()> onParsingComplete;
 
-                //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-                // Bold
-                else if (tag == "b" || tag == "strong") { fontStyle |= Font::FontStyleFlags::bold;      doSetFont(); }
-                else if (tag == "/b" || tag == "/strong") { fontStyle ^= Font::FontStyleFlags::bold;      doSetFont(); }
+    //==============================================================================
+    // Shared documents
 
-                //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-                // Underlined
-                else if (tag == "u") { fontStyle |= Font::FontStyleFlags::underlined;  doSetFont(); }
-                else if (tag == "/u") { fontStyle ^= Font::FontStyleFlags::underlined;  doSetFont(); }
+    // The parsed page, which can be shown in other views with setDocument()
+    HtmlDocument::Ptr getDocument()
+    {
+        completePendingParsing();
+        restoreMemory();
+        return document;
+    }
 
-                //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-                // Anchor
-                else if (tag.startsWithIgnoreCase("a "))
-                {
-                    prev_fontColor = fontColor;
-                    fontStyle = Font::FontStyleFlags::underlined;
-                    doSetFont();
-                    textEditor->setColour(TextEditor::ColourIds::textColourId, linkColor);
+    // Show a page parsed by another view, without parsing it again. The text is laid out for this
+    // view, the images and links are shared. Documents are never modified once shared: appending
+    // HTML to this view afterwards works on a private copy of the document.
+    void setDocument(HtmlDocument::Ptr newDocument)
+    {
+        if (newDocument == nullptr) return;
 
-                    if (tag.containsIgnoreCase("href"))
-                    {
-                        tmpHL.url = tag.fromFirstOccurrenceOf("href=", false, true).replace("\"", "");
-                        tmpHL.position.setStart(charCounter);
-                    }
-                }
-                else if (tag == "/a")
-                {
-                    fontStyle ^= Font::FontStyleFlags::underlined;
-                    doSetFont();
-                    textEditor->setColour(TextEditor::ColourIds::textColourId, prev_fontColor);
+        GSI_TRACE_SCOPE("setDocument");
 
-                    tmpHL.position.setEnd(charCounter);
-                    AllLinks.add(tmpHL);
-                }
+        Reset();
+        document = newDocument;
+        sourcesComplete = false; // Nothing to parse again, the document is kept instead
+        replayDocument();
+    }
 
-                //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-                // Font
-                else if (tag.startsWithIgnoreCase("font "))
-                {
-                    if (tag.containsIgnoreCase("size"))
-                    {
-                        prev_fontSize = fontSize;
-                        int i1 = tag.indexOf("size=") + 5; int i2 = tag.indexOfChar(i1 + 1, '"');
-                        auto val = tag.substring(i1, i2).replace("\"", "");
-                        fontSize = val.getFloatValue();
-                        doSetFont();
-                    }
+    //==============================================================================
+    // Stylesheets
 
-                    if (tag.containsIgnoreCase("color"))
-                    {
-                        prev_fontColor = fontColor;
-                        int i1 = tag.indexOf("color=") + 6; int i2 = tag.indexOfChar(i1 + 1, '"');
-                        auto val = tag.substring(i1, i2).replace("#", "");
-                        auto col = val.getHexValue32() + 0xFF000000;
-                        fontColor = Colour(col);
-                        textEditor->setColour(TextEditor::ColourIds::textColourId, fontColor);
-                    }
+    // Rules applied to all the pages shown from now on, before the ones in the <style> blocks of
+    // each page. The stylesheet can be shared by several views, but mustn't be modified anymore.
+    void setStyleSheet(HtmlStyleSheet::Ptr newStyleSheet)
+    {
+        sharedStyleSheet = newStyleSheet;
+    }
 
-                    if (tag.containsIgnoreCase("face"))
-                    {
-                        prev_fontFace = fontFace;
-                        int i1 = tag.indexOf("face=") + 6; int i2 = tag.indexOfChar(i1 + 1, '"');
-                        fontFace = tag.substring(i1, i2).replace("\"", "");
-                        doSetFont();
-                    }
-                }
-                else if (tag == "/font")
-                {
-                    fontFace = prev_fontFace;
-                    fontSize = prev_fontSize;
-                    doSetFont();
+    HtmlStyleSheet::Ptr getStyleSheet() const noexcept { return sharedStyleSheet; }
 
-                    fontColor = prev_fontColor;
-                    textEditor->setColour(TextEditor::ColourIds::textColourId, fontColor);
-                }
+    //==============================================================================
+    // Live preview, for a page that is being edited
+
+    // Show a new version of the page, replacing it. The first call renders it all. The next ones compare
+    // the HTML with the previous version and only parse the blocks that changed (paragraphs, headers,
+    // lists and pre-formatted text), keeping the rest of the page as well as the scroll position and
+    // the selection. A <style> block below the change renders it all again, and so does adding HTML
+    // to the page in any other way in between.
+    void updateHtml(const String& html)
+    {
+        GSI_TRACE_SCOPE("updateHtml");
 
-                //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-                // Font size modifiers "small" and "big"
-                else if (tag == "small")
-                {
-                    prev_fontSize = fontSize;
-                    fontSize *= 0.75f;
-                    doSetFont();
-                }
-                else if (tag == "big")
-                {
-                    prev_fontSize = fontSize;
-                    fontSize *= 1.25f;
-                    doSetFont();
-                }
-                else if (tag == "/small" || tag == "/big")
-                {
-                    fontSize = prev_fontSize;
-                    doSetFont();
-                }
+        completePendingParsing();
+        restoreMemory();
 
-                //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-                // Lists
-                else if (tag.startsWithIgnoreCase("ul"))
-                {
-                    lastListIsOrdered = false;
-                    OrderedListCounter = 1;
-                    lastIndentRange.setStart(charCounter + 1);
-                }
-                else if (tag.startsWithIgnoreCase("ol"))
-                {
-                    lastListIsOrdered = true;
-                    OrderedListCounter = 1;
-                    lastIndentRange.setStart(charCounter + 1);
-                }
-                else if (tag.startsWithIgnoreCase("li"))
-                {
-                    if (useImageIdents)
-                    {
-                        textEditor->insertTextAtCaret("\n"); charCounter++;
-                    }
-                    else
-                    {
-                        String indent = (lastListIsOrdered) ? "\n  " + String(OrderedListCounter) + ". " : "\n  - ";
-                        textEditor->insertTextAtCaret(indent);
-                        charCounter += indent.length();
-                    }
-                    OrderedListCounter++;
-                }
-                else if (tag.startsWithIgnoreCase("/ul") || tag.startsWithIgnoreCase("/ol"))
-                {
-                    if (useImageIdents)
-                    {
-                        lastIndentRange.setEnd(charCounter);
-                        textEditor->setBounds(textEditor->getBounds().withHeight(textEditor->getTextHeight()));
-                        auto b = textEditor->getTextBounds(lastIndentRange).getBounds();
-                        auto* cmp = new ImageComponent(); ImageComponents.add(cmp);
-                        cmp->setImage(textEditor->createComponentSnapshot(b));
-                        cmp->setBounds(b.translated(25, 0));
-                        textEditor->getChildComponent(0)->getChildComponent(0)->getChildComponent(0)->addAndMakeVisible(cmp);
-
-                        textEditor->setHighlightedRegion(lastIndentRange); textEditor->cut(); charCounter = lastIndentRange.getStart();
-
-                        String listSymbols;
-                        for (int i = 1; i < OrderedListCounter; i++) listSymbols += (lastListIsOrdered) ? String(i) + ".\n" : " -\n";
-                        textEditor->insertTextAtCaret(listSymbols);
-                        charCounter += listSymbols.length();
-                    }
+        if (preview.states.isEmpty())
+        {
+            renderPreview(html);
+            return;
+        }
 
-                    // Add newline after unordered (or ordered) list
-                    lastChar = '\n'; textEditor->insertTextAtCaret("\n"); charCounter++;
-                    lastListIsOrdered = false;
-                }
+        auto previousSource = preview.source;
+        auto* oldData = previousSource.toRawUTF8();
+        auto* newData = html.toRawUTF8();
+        auto oldSize = previousSource.getNumBytesAsUTF8();
+        auto newSize = html.getNumBytesAsUTF8();
 
-                //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-                // Headers
-                else if (tag.startsWithIgnoreCase("h") && tag.containsAnyOf("1234"))
-                {
-                    prev_fontSize = fontSize;
-                    auto sz = tag.getLastCharacters(1).getIntValue();
-                    fontSize = 40 - sz * 4;
-                    doSetFont();
-                }
-                else if (tag.startsWithIgnoreCase("/h") && tag.containsAnyOf("1234"))
-                {
-                    fontSize = prev_fontSize;
-                    doSetFont();
+        // The bytes that are the same at the beginning and at the end of both versions
+        size_t sameStart = 0, sameEnd = 0;
+        auto shorter = jmin(oldSize, newSize);
+        while (sameStart < shorter && oldData[sameStart] == newData[sameStart]) sameStart++;
+        while (sameEnd < shorter - sameStart && oldData[oldSize - 1 - sameEnd] == newData[newSize - 1 - sameEnd]) sameEnd++;
 
-                    // Add double newline after header text
-                    lastChar = '\n'; textEditor->insertTextAtCaret("\n\n"); charCounter += 2;
-                }
+        if (sameStart == oldSize && oldSize == newSize)
+            return;
 
-                //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-                // Paragraph
-                else if (tag.startsWithIgnoreCase("p ") || tag == "p")
-                {
-                    // Add newline before paragraph
-                    lastChar = '\n'; textEditor->insertTextAtCaret("\n"); charCounter++;
+        // Parse again from the end of the last block that didn't change...
+        int restart = preview.states.size() - 1;
+        while (restart >= 0 && preview.states.getReference(restart).offset > sameStart) restart--;
 
-                    if (tag.containsIgnoreCase("style"))
-                    {
-                        int i1 = tag.indexOf("style=") + 6; int i2 = tag.indexOfChar(i1 + 1, '"');
-                        auto styleString = tag.substring(i1, i2).replace("\"", "");
-                        parseInlineStyle(styleString);
-                    }
-                }
-                else if (tag == "/p")
-                {
-                    // Add newline after paragraph
-                    lastChar = '\n'; textEditor->insertTextAtCaret("\n"); charCounter++;
-                }
+        auto restartOffset = restart >= 0 ? preview.states.getReference(restart).offset : 0;
 
-                //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-                // Span
-                else if (tag.startsWithIgnoreCase("span "))
-                {
-                    if (tag.containsIgnoreCase("style"))
-                    {
-                        int i1 = tag.indexOf("style=") + 6; int i2 = tag.indexOfChar(i1 + 1, '"');
-                        auto styleString = tag.substring(i1, i2).replace("\"", "");
-                        parseInlineStyle(styleString);
-                    }
-                }
-                else if (tag == "/span")
-                {
-                    fontSize = prev_fontSize;
-                    fontColor = prev_fontColor;
-                    fontFace = prev_fontFace;
-                    fontStyle = Font::FontStyleFlags::plain;
-                    doSetFont();
-
-                    fontColor = prev_fontColor;
-                    textEditor->setColour(TextEditor::ColourIds::textColourId, fontColor);
-                }
+        // Rules only apply to what follows them, the blocks parsed again would get the ones of a <style>
+        // block further down the page
+        if (restart < 0 || HtmlStringView(oldData + restartOffset, oldData + oldSize).containsIgnoreCase("<style")
+                        || HtmlStringView(newData + restartOffset, newData + newSize).containsIgnoreCase("<style"))
+        {
+            renderPreview(html);
+            return;
+        }
 
-                //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-                // Pre-formatted
-                else if (tag.startsWithIgnoreCase("pre"))
-                {
-                    renderPreFormatted = true;
+        // ...until the first block of what didn't change at the end, if the page can be joined there.
+        // The kept part is moved as a whole, so the images and list snapshots before it can't be laid out
+        // yet. It must also start on a new line with nothing left open.
+        int kept = restart + 1;
+        while (kept < preview.states.size() && preview.states.getReference(kept).offset < oldSize - sameEnd) kept++;
 
-                    fontStyle = Font::FontStyleFlags::plain;
-                    prev_fontFace = fontFace;
-                    prev_fontSize = fontSize;
-                    fontSize = 12;
-                    fontFace = Font::getDefaultMonospacedFontName();
-                    doSetFont();
+        if (kept < preview.states.size())
+        {
+            auto& keptState = preview.states.getReference(kept);
+            HtmlStringView newPart(newData + restartOffset, newData + keptState.offset + newSize - oldSize);
 
-                    if (tag.containsIgnoreCase("style"))
-                    {
-                        int i1 = tag.indexOf("style=") + 6; int i2 = tag.indexOfChar(i1 + 1, '"');
-                        auto styleString = tag.substring(i1, i2).replace("\"", "");
-                        parseInlineStyle(styleString, false);
-                    }
-                }
-                else if (tag == "/pre")
-                {
-                    renderPreFormatted = false;
-                    fontSize = prev_fontSize;
-                    fontFace = prev_fontFace;
-                    doSetFont();
+            if (useImageIdents || newPart.containsIgnoreCase("<img") || keptState.lastChar != '\n' || keptState.openLink.url.isNotEmpty())
+                kept = -1;
+        }
+        else
+        {
+            kept = -1;
+        }
 
-                    fontColor = prev_fontColor;
-                    textEditor->setColour(TextEditor::ColourIds::textColourId, fontColor);
-                }
+        // Keep the reader where they are
+        auto* viewport = mobileStyle ? &mobileStyleViewPort : getEditorViewport();
+        auto viewPosition = viewport != nullptr ? viewport->getViewPosition() : juce::Point<int>();
+        auto selection = textEditor->getHighlightedRegion();
+        auto caretPosition = textEditor->getCaretPosition();
+
+        renderStats = RenderStats();
+        allocatedBytesAtStart = AllocationCounter::getNumBytes();
+
+        // The previous version is held until the kept part is copied from it, which also makes the
+        // document below a copy
+        preview.previousDocument = document;
+        preview.previousStates = std::move(preview.states);
+        preview.previousEndState = preview.endState;
+        preview.previousTextHeight = totalTextHeight;
+        preview.source = html;
+        jassert(sources.size() == 1);
+        sources.getReference(0).text = html;
+
+        const auto from = preview.previousStates.getReference(restart);
+        preview.states.addArray(preview.previousStates, 0, restart + 1);
+        preview.restartCharCounter = from.charCounter;
+
+        // Remove what changed from the page and the document
+        auto totalChars = textEditor->getTotalNumChars();
+        auto removedEnd = kept >= 0 ? preview.previousStates.getReference(kept).textLength : totalChars;
+        auto removedImages = (kept >= 0 ? preview.previousStates.getReference(kept).numImageComponents : ImageComponents.size()) - from.numImageComponents;
+
+        removeText({ from.textLength, removedEnd });
+        ImageComponents.removeRange(from.numImageComponents, removedImages);
+        truncateDocument(from);
+
+        if (kept >= 0)
+        {
+            preview.keptState = kept;
+            preview.keptStart = newData + preview.previousStates.getReference(kept).offset + newSize - oldSize;
+            preview.keptTextLength = totalChars - removedEnd;
+            preview.numKeptImageComponents = ImageComponents.size() - from.numImageComponents;
+        }
 
-                //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-                // Image
-                else if (tag.startsWithIgnoreCase("img "))
-                {
-                    int i1 = tag.indexOf("src=") + 5; int i2 = tag.indexOfChar(i1 + 1, '"');
-                    auto ImgSrc = tag.substring(i1, i2).replace("\"", "");
+        // Parse from there, with the style the page had at that point
+        parser = ParserState();
+        parser.position = newData + from.offset;
+        parser.end = newData + newSize;
+        restoreBlockState(from);
 
-                    MemoryBlock imgMemBlock;
+        auto& doc = *document;
+        if (from.numFonts > 0)      textEditor->setFont(doc.fonts.getReference(from.numFonts - 1));
+        if (from.numColours > 0)    textEditor->setColour(TextEditor::ColourIds::textColourId, doc.colours[from.numColours - 1]);
+        textEditor->setCaretPosition(from.textLength);
 
-                    // Search image in the resources
-                    int size(0);
-                    auto data = BinaryData::getNamedResource(ImgSrc.replace(".", "_").replace("-", "").toRawUTF8(), size);
+        // A block that was just removed, the kept part follows right away
+        if (preview.keptStart == parser.position && from.continuesLike(preview.previousStates.getReference(kept)))
+            preview.keptPartReached = true;
+        else
+            parsePreview();
 
-                    // If image wasn't in the resource, attempt to load it from disk
-                    if (size == 0)
-                    {
-                        auto ImgFile = File(File::getCurrentWorkingDirectory().getFullPathName() + File::getSeparatorString() + ImgSrc);
-                        if (ImgFile.existsAsFile())
-                        {
-                            ImgFile.loadFileAsData(imgMemBlock);
-                            size = imgMemBlock.getSize();
-                            data = (const char*)imgMemBlock.getData();
-                        }
-                    }
+        int textShift = 0;
+        bool joined = preview.keptPartReached;
+        if (joined) textShift = joinKeptPart();
+        else preview.endState = captureBlockState(parser.end);
 
-                    if (size > 0)
-                    {
-                        ImagesInThisDocument.add(ImgSrc);
-
-                        auto img = IMAGE_FROM_DATA_SIZE; //ImageCache::getFromMemory(data, size);
-                        auto* cmp = ImageComponents.add(new ImageComponent(ImgSrc));
-                        cmp->setImage(img);
-                        int lastFontHeight = textEditor->getFont().getHeight();
-                        int w = img.getWidth();
-                        int h = img.getHeight();
-
-                        // Resize image (set width, keep aspect ratio)
-                        if (tag.containsIgnoreCase("width"))
-                        {
-                            int i1 = tag.indexOf("width=") + 6; int i2 = tag.indexOfChar(i1 + 1, '"');
-                            auto val = tag.substring(i1, i2).replace("\"", "").getIntValue();
-                            if (val > 0)
-                            {
-                                auto ratio = (float)h / (float)w;
-                                w = val;
-                                h = w * ratio;
-                            }
-                        }
-
-                        // Set Image size and position
-                        int x = textEditor->getLeftIndent();
-                        int y = textEditor->getTextHeight() - lastFontHeight * 2;
-                        cmp->setBounds(x, y, w, h);
-
-                        // Now this is tricky! There's no way to get the viewport that contains the text in a TextEditor.
-                        // This method digs into the component until reaching the viewport.
-                        // Works with Juce 6.1.6 but may break if the class is modified in future versions of Juce.
-                        textEditor->getChildComponent(0)->getChildComponent(0)->getChildComponent(0)->addAndMakeVisible(cmp);
-
-                        // Now calculate the amount of break lines needed to move the text right below the image using the last font height
-                        int shiftY = round((float)h / (float)lastFontHeight);
-                        for (int i = 0; i < shiftY; i++)
-                        {
-                            lastChar = '\n'; textEditor->insertTextAtCaret("\n"); charCounter++;
-                        }
-                    }
+        preview.previousDocument = nullptr;
+        preview.previousStates.clear();
 
-                    else
-                    {
-                        String errMsg("[NOT FOUND: " + ImgSrc + "]\n");
-                        textEditor->insertTextAtCaret(errMsg);
-                        charCounter += errMsg.length();
-                    }
-                }
+        ImagesInThisDocument.clear();
+        for (auto& image : document->images)
+            ImagesInThisDocument.add(image.source);
 
-                //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-                tag.clear();
-                continue;
-            }
+        finishParsing();
 
-            // Skip multiple new lines
-            if (lastChar == '\n' && s == '\n') continue;
+        // The selection stays on the same text, if it's still there
+        if (selection.getEnd() > from.textLength)
+        {
+            if (joined && selection.getStart() >= removedEnd) selection += textShift;
+            else selection = {};
+        }
 
-            // Don't render white spaces at begin of new line
-            if (lastChar == '\n' && s == ' ') continue;
+        if (!selection.isEmpty()) textEditor->setHighlightedRegion(selection);
+        else textEditor->setCaretPosition(jmin(caretPosition, textEditor->getTotalNumChars()));
 
-            // Don't render multiple white spaces
-            if (lastChar == ' ' && s == ' ') continue;
+        if (viewport != nullptr) viewport->setViewPosition(viewPosition);
+    }
 
-            // Replace new line with white space
-            lastChar = (s == '\n') ? ' ' : s;
+    //==============================================================================
+    // Where the time went while loading the last page (all times in milliseconds)
 
-            // Add the plain characters to the output buffer
-            output += String::charToString(lastChar);
-            charCounter++;
+    struct RenderStats
+    {
+        double totalMs = 0.0;
+        double tokenizeMs = 0.0;        // Reading characters, tags and entities (what's left out of the other phases)
+        double styleMs = 0.0;           // Applying fonts and colours to the TextEditor
+        double insertMs = 0.0;          // Inserting text into the TextEditor
+        double layoutMs = 0.0;          // Measuring the text height
+        double imageDecodeMs = 0.0;     // Loading and decoding images
+        int doSetFontCalls = 0;
+        int typefaceCreations = 0;
+        int insertTextCalls = 0;
+        int64 bytesAllocated = -1;      // By the whole process while loading, -1 if allocations aren't counted
+        bool truncated = false;         // The page went over ParserLimits::maxOutputChars
+
+        String toString() const
+        {
+            return "total " + String(totalMs, 2) + " ms (tokenize " + String(tokenizeMs, 2) + ", style " + String(styleMs, 2)
+                + ", insert " + String(insertMs, 2) + ", layout " + String(layoutMs, 2) + ", images " + String(imageDecodeMs, 2)
+                + "), " + String(doSetFontCalls) + " fonts set, " + String(typefaceCreations) + " typefaces created, "
+                + String(insertTextCalls) + " text insertions, " + String(bytesAllocated) + " bytes allocated"
+                + (truncated ? ", truncated" : "");
         }
+    };
 
-        // Print the remaining output buffer
-        textEditor->setCaretPosition(charCounter);
-        textEditor->insertTextAtCaret(output);
+    // Complete once isParsing() returns false
+    const RenderStats& getRenderStats() const
+    {
+        return renderStats;
+    }
 
-        totalTextHeight = textEditor->getTextHeight();
-        DBG("Text Height: " << totalTextHeight);
+    // Caps that keep a broken or hostile page from hanging the parser or taking too much memory.
+    // The parser recovers from anything over a limit and goes on with the rest of the page.
+    struct ParserLimits
+    {
+        int maxTagLength = 64 * 1024;           // Bytes in a tag or a comment, one that doesn't end is dropped there
+        int maxEntityLength = 32;               // Bytes after a '&' without a ';', then the '&' is just text
+        int maxNestingDepth = 256;              // Open elements, the outermost ones are forgotten past that
+        int maxImageSize = 4096;                // Width and height of the images shown, in pixels
+        float maxFontSize = 200.f;              // Nested <big> or <font size> can't make the text bigger than this
+        int maxOutputChars = 64 * 1024 * 1024;  // Characters in the page, whatever comes after is left out
+    };
+
+    void setParserLimits(const ParserLimits& newLimits)
+    {
+        limits = newLimits;
+    }
 
-        if (mobileStyle) resized();
+    const ParserLimits& getParserLimits() const
+    {
+        return limits;
     }
 
+    //==============================================================================
+
     // Pass a string to search for in the current document, or an empty string to clear search results
     bool searchAndHighlight(const String& keywords, bool restart = true)
     {
+        completePendingParsing(); // The match may be further than what's been parsed so far
+        restoreMemory();
+
         // Reset search
         if (keywords.isEmpty())
         {
@@ -706,41 +635,88 @@ public:
 
     int GetScrollY()
     {
-        if (mobileStyle)
-            return mobileStyleViewPort.getViewPositionY();
-        else
-            return textEditor->getCaretRectangle().getY(); // Could not be accurate!
+        auto* viewport = mobileStyle ? &mobileStyleViewPort : getEditorViewport();
+        return viewport != nullptr ? viewport->getViewPositionY() : 0;
     }
 
     void SetScrollY(int y)
     {
-        if (mobileStyle)
-            mobileStyleViewPort.setViewPosition(0, y);
-        // else ???
+        auto* viewport = mobileStyle ? &mobileStyleViewPort : getEditorViewport();
+        if (viewport != nullptr)
+            viewport->setViewPosition(viewport->getViewPositionX(), jmax(0, y));
+    }
+
+    // Scroll the page so that a named anchor (<a name="..."> or the id of an element) is at the top.
+    // Returns false if the page doesn't have it.
+    bool scrollToAnchor(const String& name)
+    {
+        completePendingParsing();
+        restoreMemory();
+
+        auto position = document->getAnchorPosition(name);
+        if (position < 0) return false;
+
+        SetScrollY(getTextY(position));
+        return true;
     }
 
     //==============================================================================
 
-    Image getPageSnapshot()
+    // The area of the text editor that contains the entire rendered page
+    Rectangle<int> getPageArea()
     {
-        return textEditor->createComponentSnapshot({ 0, 0, textEditor->getWidth() - mobileStyleViewPort.getScrollBarThickness(), totalTextHeight }, false);
+        completePendingParsing();
+        restoreMemory();
+        return { 0, 0, textEditor->getWidth() - mobileStyleViewPort.getScrollBarThickness(), totalTextHeight };
     }
 
-    // Export a PNG snapshot of the entire rendered page, works best in MobileStyle
-    bool exportPageToImage(const URL& url)
+    // Note: the whole page is rendered in one Image, use exportPageToImage() for very tall pages
+    Image getPageSnapshot()
     {
-        if (!url.isLocalFile()) return false;
-
-        return (url.getLocalFile().deleteFile()) ?
-            PNGImageFormat().writeImageToStream(getPageSnapshot(), *url.createOutputStream())
-            : false;
+        return textEditor->createComponentSnapshot(getPageArea(), false);
     }
 
-    //==============================================================================
+    // Render a horizontal slice of the page
+    Image getPageTile(int y, int height)
+    {
+        return textEditor->createComponentSnapshot({ 0, y, getPageArea().getWidth(), height }, false);
+    }
 
-    void paintOverChildren(juce::Graphics& g) override
+    // Export a PNG snapshot of the entire rendered page, works best in MobileStyle.
+    // The page is rendered in tiles that are compressed as they go, so only one tile is held in memory.
+    bool exportPageToImage(const URL& url, int tileHeight = 256)
     {
-        if (hoverLink)
+        if (!url.isLocalFile() || !url.getLocalFile().deleteFile()) return false;
+
+        auto area = getPageArea();
+        auto stream = url.createOutputStream();
+        if (stream == nullptr || area.isEmpty()) return false;
+
+        StreamingPngWriter png(*stream, area.getWidth(), area.getHeight());
+
+        for (int y = 0; y < area.getHeight(); y += tileHeight)
+        {
+            if (!png.writeRows(getPageTile(y, jmin(tileHeight, area.getHeight() - y)))) return false;
+        }
+
+        return png.finish();
+    }
+
+    //==============================================================================
+
+    // Nothing to draw here, the text is painted by the TextEditor. This only starts the frame timer
+    // that paintOverChildren() stops, once the children have been painted too.
+    void paint(juce::Graphics&) override
+    {
+        paintStartTicks = Time::getHighResolutionTicks();
+        restoreMemorySoon();
+    }
+
+    void paintOverChildren(juce::Graphics& g) override
+    {
+        GSI_TRACE_SCOPE("paintOverChildren");
+
+        if (hoverLink)
         {
             hoverPosition.x = jlimit<int>(0, getWidth() - toolTipWidth, hoverPosition.x);
             hoverPosition.y = jlimit<int>(0, getHeight() - 25, hoverPosition.y);
@@ -751,10 +727,22 @@ public:
             g.setColour(Colours::black);
             g.drawText(hoverLinkText, hoverPosition.x, hoverPosition.y, toolTipWidth, 25, Justification::centred);
         }
+
+        lastPaintMs = getElapsedMs(paintStartTicks);
+    }
+
+    // How long the last repaint of this view took, children included
+    double getLastPaintMs() const
+    {
+        return lastPaintMs;
     }
 
     void resized() override
     {
+        GSI_TRACE_SCOPE("resized");
+
+        if (isShowing()) restoreMemorySoon();
+
         textEditor->setBounds(0, 0, getWidth() - mobileStyleViewPort.getScrollBarThickness(), mobileStyle ? totalTextHeight : getHeight());
 
         if (transparentLayer != nullptr)
@@ -766,6 +754,8 @@ public:
 
     void mouseMove(const MouseEvent& event) override
     {
+        GSI_TRACE_SCOPE("mouseMove");
+
         if (textEditor->getMouseCursor() != MouseCursor::NormalCursor)
         {
             textEditor->setMouseCursor(MouseCursor::NormalCursor);
@@ -773,44 +763,240 @@ public:
             repaint();
         }
 
-        for (auto l : AllLinks)
+        auto index = getLinkIndexAt(event.getPosition());
+        if (index < 0) return;
+
+        const auto& l = document->links.getReference(index);
+        textEditor->setMouseCursor(MouseCursor::PointingHandCursor);
+        if (!l.url.startsWithIgnoreCase("http") || !showAnchorPopup) return;
+
+        hoverLink = true;
+        hoverLinkText = l.url;
+        toolTipWidth = toolTipFont.getStringWidth(hoverLinkText) + 10;
+        hoverPosition = event.getPosition() + juce::Point<int>(15, 15);
+        repaint();
+    }
+
+    void mouseUp(const MouseEvent& event) override
+    {
+        auto index = getLinkIndexAt(event.getPosition());
+        if (index < 0) return;
+
+        auto url = document->links.getReference(index).url;
+        if (url.startsWithIgnoreCase("http"))
         {
-            int i = textEditor->getTextIndexAt(event.x, event.y);
-            if (l.position.contains(i))
-            {
-                textEditor->setMouseCursor(MouseCursor::PointingHandCursor);
-                if (!l.url.startsWithIgnoreCase("http") || !showAnchorPopup) break;
+            URL w(url);
+            w.launchInDefaultBrowser();
+        }
+        else if (url.startsWith("#") && scrollToAnchor(url.substring(1)))
+        {
+            // A link to another part of this page
+        }
+        else
+        {
+            if (internalLinkFunction != nullptr)
+                internalLinkFunction(url);
+        }
+    }
 
-                hoverLink = true;
-                hoverLinkText = l.url;
-                toolTipWidth = toolTipFont.getStringWidth(hoverLinkText) + 10;
-                hoverPosition = event.getPosition() + juce::Point<int>(15, 15);
-                repaint();
-                break;
+    // Returns the index of the link under the given position, or -1
+    int getLinkIndexAt(juce::Point<int> position)
+    {
+        int i = textEditor->getTextIndexAt(position.x, position.y);
+
+        const auto& links = document->links;
+
+        for (int n = 0; n < links.size(); n++)
+            if (links.getReference(n).position.contains(i))
+                return n;
+
+        return -1;
+    }
+
+    int getNumLinks() const
+    {
+        return document->links.size();
+    }
+
+    int getNumImageComponents() const
+    {
+        return ImageComponents.size();
+    }
+
+    // Typefaces loaded from the resources, shared by all the views
+    static int getNumCachedTypefaces()
+    {
+        const ScopedLock sl(getTypefaceCacheLock());
+        int count = 0;
+
+        for (HashMap<String, CachedTypeface>::Iterator i(getTypefaceCache()); i.next();)
+            if (i.getValue().typeface != nullptr)
+                count++;
+
+        return count;
+    }
+
+    // Memory taken by the decoded images, each image counted once even if shown more than once
+    int64 getDecodedImageBytes() const
+    {
+        Array<ImagePixelData*> counted;
+        int64 bytes = 0;
+
+        for (auto* cmp : ImageComponents)
+        {
+            auto img = cmp->getImage();
+            if (img.isValid() && counted.addIfNotAlreadyThere(img.getPixelData().get()))
+                bytes += (int64)img.getWidth() * img.getHeight() * (img.getFormat() == Image::SingleChannel ? 1 : 4);
+        }
+
+        return bytes;
+    }
+
+    // Number of characters in the TextEditor
+    int getDocumentLength() const
+    {
+        return textEditor->getTotalNumChars();
+    }
+
+    //==============================================================================
+    // Memory accounting and trimming
+
+    // Approximate number of bytes held by each part of the page
+    struct MemoryUsage
+    {
+        int64 text = 0;             // Laid out text in the TextEditor (estimated)
+        int64 images = 0;           // Decoded <img> images
+        int64 listSnapshots = 0;    // Snapshots made for image indents
+        int64 document = 0;         // Parsed document including the links, may be shared with other views
+        int64 source = 0;           // Copies of the HTML kept to rebuild the page after trimMemory()
+        int64 typefaces = 0;        // Embedded fonts, shared by all the instances
+
+        int64 getTotal() const { return text + images + listSnapshots + document + source + typefaces; }
+    };
+
+    MemoryUsage getMemoryUsage() const
+    {
+        MemoryUsage usage;
+        usage.text = (int64)textEditor->getTotalNumChars() * approxBytesPerChar;
+
+        for (auto* cmp : ImageComponents)
+        {
+            auto img = cmp->getImage();
+            if (cmp->getName().isEmpty() && img.isValid())
+                usage.listSnapshots += (int64)img.getWidth() * img.getHeight() * 4;
+        }
+
+        usage.images = getDecodedImageBytes() - usage.listSnapshots;
+
+        usage.document = document->getMemorySize();
+
+        for (auto& s : sources)
+            usage.source += (int64)s.text.getNumBytesAsUTF8();
+
+        const ScopedLock sl(getTypefaceCacheLock());
+        for (HashMap<String, CachedTypeface>::Iterator i(getTypefaceCache()); i.next();)
+            usage.typefaces += i.getValue().dataSize;
+
+        return usage;
+    }
+
+    enum TrimLevel
+    {
+        trimCaches = 1,     // Unused typefaces, the image cache and the link tooltip
+        trimImages,         // Also the decoded images, they are loaded again when needed
+        trimEverything      // Also the text, the page is rebuilt when needed
+    };
+
+    // Release memory while the page isn't shown, e.g. when the application is in the background.
+    // The page comes back when restoreMemory() is called, or soon after the view is shown again:
+    // made visible itself, painted, or resized while showing (hiding a parent doesn't tell the view).
+    // trimEverything needs all the HTML to be still available (see appendHtml()), or the document
+    // to be shared with another view, otherwise the images are trimmed only.
+    // Returns the level that was actually applied.
+    int trimMemory(int level)
+    {
+        completePendingParsing();
+
+        // Dropping a shared document wouldn't free anything, it's kept to rebuild the page without parsing
+        bool documentIsShared = document->getReferenceCount() > 1;
+
+        if (level >= trimEverything && !sourcesComplete && !documentIsShared)
+            level = trimImages;
+
+        if (level >= trimEverything && trimLevel < trimEverything)
+        {
+            auto* viewport = mobileStyle ? &mobileStyleViewPort : getEditorViewport();
+            trimmedViewPosition = viewport != nullptr ? viewport->getViewPosition() : juce::Point<int>();
+
+            textEditor->clear();
+            ImageComponents.clear();
+            charCounter = 0;
+
+            if (!documentIsShared)
+            {
+                document = new HtmlDocument();
+                documentReleased = true;
             }
         }
+        else if (level >= trimImages)
+        {
+            // Snapshots of lists have no name and can't be loaded again, so they are kept
+            for (auto* cmp : ImageComponents)
+                if (cmp->getName().isNotEmpty())
+                    cmp->setImage(Image());
+
+            if (!documentIsShared)
+                for (auto& entry : document->images)
+                    entry.image = Image();
+        }
+
+        if (level >= trimCaches)
+        {
+            hoverLink = false;
+            hoverLinkText = String();
+            releaseUnusedTypefaces();
+            ImageCache::releaseUnusedImages();
+        }
+
+        trimLevel = jmax(trimLevel, level);
+        return level;
     }
 
-    void mouseUp(const MouseEvent& event) override
+    // Bring back what trimMemory() released
+    void restoreMemory()
     {
-        for (auto l : AllLinks)
+        if (trimLevel >= trimEverything)
+        {
+            auto searchString = lastSearchString;
+            auto searchEndIndex = lastSearchEndIndex;
+
+            if (documentReleased) rebuildFromSources();
+            else replayDocument();
+
+            lastSearchString = searchString;
+            lastSearchEndIndex = searchEndIndex;
+
+            auto* viewport = mobileStyle ? &mobileStyleViewPort : getEditorViewport();
+            if (viewport != nullptr) viewport->setViewPosition(trimmedViewPosition);
+        }
+        else if (trimLevel >= trimImages)
         {
-            int i = textEditor->getTextIndexAt(event.x, event.y);
-            if (l.position.contains(i))
+            for (auto* cmp : ImageComponents)
             {
-                if (l.url.startsWithIgnoreCase("http"))
-                {
-                    URL w(l.url);
-                    w.launchInDefaultBrowser();
-                }
-                else
+                if (cmp->getName().isNotEmpty() && !cmp->getImage().isValid())
                 {
-                    if (internalLinkFunction != nullptr)
-                        internalLinkFunction(l.url);
+                    cmp->setImage(loadImage(cmp->getName()));
+                    if (!cmp->getImage().isValid()) loadImageLater(cmp);
                 }
-                break;
             }
         }
+
+        trimLevel = 0;
+    }
+
+    void visibilityChanged() override
+    {
+        if (isVisible()) restoreMemory();
     }
 
 
@@ -829,10 +1015,23 @@ private:
     Viewport mobileStyleViewPort;
 
     int charCounter, lastSearchEndIndex;
-    String fontFace, prev_fontFace;
-    float fontSize, prev_fontSize;
+    String fontFace;
+    float fontSize;
     int fontStyle = Font::FontStyleFlags::plain;
-    Colour fontColor, prev_fontColor, linkColor = Colours::yellow;
+    Colour fontColor, linkColor = Colours::yellow;
+
+    struct TextStyle
+    {
+        String face;
+        float size;
+        Colour colour;
+        int flags;
+
+        bool operator== (const TextStyle& other) const noexcept
+        {
+            return face == other.face && size == other.size && colour == other.colour && flags == other.flags;
+        }
+    };
     bool showAnchorPopup = true;
     bool mobileStyle = false;
     int totalTextHeight = 0;
@@ -846,83 +1045,1924 @@ private:
     Font toolTipFont = Font("Arial", 14.f, Font::FontStyleFlags::plain);
     int toolTipWidth = 100;
 
+    int64 paintStartTicks = 0;
+    double lastPaintMs = 0.0;
+
     OwnedArray<ImageComponent> ImageComponents;
     juce::Range<int> lastIndentRange;
 
-    struct HyperLink
+    HtmlDocument::Link tmpHL;
+
+    // What this view shows, possibly shared with other views. Everything the parser does to the
+    // TextEditor is recorded here, so that another view can show the page without parsing it.
+    HtmlDocument::Ptr document;
+    bool documentReleased = false;
+
+    HtmlStyleSheet::Ptr sharedStyleSheet;
+    HtmlStyleSheet pageStyleSheet; // Rules from the <style> blocks of the page being parsed
+
+    //==============================================================================
+    // Parser state, kept between calls so that a page can be parsed in several slices
+
+    // Text waiting to be inserted, collected as UTF-8. The buffer grows as needed and is
+    // reused for the whole parse, then released in one go when the parse is over.
+    struct TextBuffer
     {
-        String url;
-        Range<int> position;
-    } tmpHL;
-    Array<HyperLink> AllLinks;
+        HeapBlock<char> data;
+        size_t size = 0, allocated = 0;
 
-    void doSetFont()
+        bool isEmpty() const noexcept { return size == 0; }
+        void clear() noexcept { size = 0; }
+
+        void add(juce_wchar c)
+        {
+            ensureSpace(4);
+            CharPointer_UTF8 dest(data + size);
+            dest.write(c);
+            size = (size_t)(dest.getAddress() - data.get());
+        }
+
+        void add(const char* ascii)
+        {
+            auto n = strlen(ascii);
+            ensureSpace(n);
+            memcpy(data + size, ascii, n);
+            size += n;
+        }
+
+        bool endsWithIgnoreCase(const char* ascii) const noexcept
+        {
+            auto n = strlen(ascii);
+            return size >= n && HtmlStringView(data + size - n, data + size).equalsIgnoreCase(ascii);
+        }
+
+        void removeLast(size_t numBytes) noexcept { size -= jmin(size, numBytes); }
+
+        String toString() const { return String::fromUTF8(data, (int)size); }
+
+        void ensureSpace(size_t numBytes)
+        {
+            if (size + numBytes <= allocated) return;
+            allocated = jmax((size_t)1024, (size + numBytes) * 2);
+            data.realloc(allocated);
+        }
+    };
+
+    struct ParserState
     {
-        //textEditor->setFont(Font(fontFace, fontSize, fontStyle));
+        bool beginTag = false, canParseTag = false;
+        bool beginEncoded = false, canParseEncoding = false;
+        bool renderPreFormatted = false;
+        HtmlStringView tag, code;   // Both point into the HTML being parsed
+        TextBuffer output;
+        juce_wchar lastChar = 0;
+        const char* position = nullptr;
+        const char* end = nullptr;
+        const char* commentStart = nullptr;
+        bool truncated = false;     // Over ParserLimits::maxOutputChars, the rest is left out
+    } parser;
+
+    String progressiveSource;
+    std::unique_ptr<MemoryMappedFile> progressiveMappedFile;
+    double progressiveTimeSlice = 4.0;
+    ParserLimits limits;
+
+    // Where to save the page once parsed, see loadHtmlFileWithCache()
+    HtmlDocumentDiskCache* diskCacheToStore = nullptr;
+    File fileToStore;
+    int64 settingsToStore = 0;
+
+    // Everything but the HTML that changes the parsed document, for the disk cache
+    int64 getParserSettingsSignature() const
+    {
+        // The style the page starts with is recorded by Reset(), and the link colour goes in the colour table
+        auto style = getCurrentStyle();
+
+        String description;
+        description << limits.maxTagLength << ';' << limits.maxEntityLength << ';' << limits.maxNestingDepth << ';'
+                    << limits.maxImageSize << ';' << limits.maxFontSize << ';' << limits.maxOutputChars << ';'
+                    << (sharedStyleSheet != nullptr ? sharedStyleSheet->getSignature() : (int64)0) << ';'
+                    << style.face << ';' << style.size << ';' << (int64)style.colour.getARGB() << ';' << style.flags << ';'
+                    << (int64)linkColor.getARGB() << ';' << (int)useImageIdents << ';' << (int)mobileStyle;
+
+        return description.hashCode64();
+    }
+
+    void parseNow(const char* utf8, size_t numBytes)
+    {
+        completePendingParsing();
+        beginParsing(utf8, numBytes);
+
+        if (parallelParsingThreshold > 0 && numBytes >= parallelParsingThreshold && parallelParsingThreads > 1)
+            parseInParallel();
+        else
+            parseSlice(0.0, false);
+
+        finishParsing();
+    }
 
-        auto theFont = Font(fontFace, fontSize, fontStyle);
+    void startProgressiveParsing(const char* utf8, size_t numBytes)
+    {
+        completePendingParsing();
+        beginParsing(utf8, numBytes);
 
-        auto fontHeight = fontSize;
-        int ff_size(0);
-        auto ff_data = BinaryData::getNamedResource(fontFace.replace(".", "_").replace("-", "").toRawUTF8(), ff_size);
-        if (ff_size > 0)
+        // Fill the visible area first, without any time limit
+        if (parseSlice(0.0, true))
         {
-            theFont = Font(Typeface::createSystemTypefaceFor(ff_data, ff_size));
-            //#if JUCE_MAC || JUCE_IOS
-            //fontHeight *= 0.75f; // Fonts look bigger on iOS and Mac OS!
-            //#endif
+            finishParsing();
+            return;
         }
 
-        theFont.setHeight(fontHeight);
-        theFont.setStyleFlags(fontStyle);
+        flushPendingOutput();
+        totalTextHeight = getLaidOutTextHeight();
+        if (mobileStyle) resized();
+
+        startTimer(1);
+    }
+
+    //==============================================================================
+    // Where the HTML of the page came from, so that it can be parsed again after trimMemory()
+
+    struct SourceChunk
+    {
+        File file;
+        String text;
+        const char* permanentData = nullptr;
+        size_t size = 0;
+
+        bool isValid() const { return file != File() || text.isNotEmpty() || permanentData != nullptr; }
+    };
+
+    TextStyle initialStyle;
+
+    Array<SourceChunk> sources;
+    bool sourcesComplete = true;
+    int trimLevel = 0;
+    bool restorePending = false;
+    juce::Point<int> trimmedViewPosition;
+
+    // From paint() and resized(), where the page can't be rebuilt right away
+    void restoreMemorySoon()
+    {
+        if (trimLevel == 0 || restorePending) return;
+
+        restorePending = true;
+        MessageManager::callAsync([safeThis = SafePointer<GSiHtmlTextEdit>(this)]
+        {
+            if (safeThis == nullptr) return;
+            safeThis->restorePending = false;
+            safeThis->restoreMemory();
+        });
+    }
+
+    static constexpr int approxBytesPerChar = 8; // UTF-8 text plus the TextEditor's per-word layout atoms
+
+    void recordSource(const SourceChunk& source)
+    {
+        // Appending to a trimmed page, bring it back first
+        restoreMemory();
+
+        if (sources.isEmpty())
+            initialStyle = getCurrentStyle();
+
+        // The page no longer matches the live preview's HTML
+        preview = LivePreview();
+
+        if (source.isValid()) sources.add(source);
+        else sourcesComplete = false;
+    }
+
+    void rebuildFromSources()
+    {
+        GSI_TRACE_SCOPE("rebuildFromSources");
+
+        auto savedSources = sources;
+        auto style = initialStyle;
+
+        Reset();
+        setCurrentStyle(style);
+        doSetFont();
+        setTextColour(fontColor);
+
+        for (auto& s : savedSources)
+        {
+            if (s.file != File()) appendHtmlFromFile(s.file);
+            else if (s.permanentData != nullptr) appendHtml(s.permanentData, s.size, true);
+            else appendHtml(s.text);
+        }
+    }
+
+    void beginParsing(const char* utf8, size_t numBytes)
+    {
+        parser = ParserState();
+        parser.position = utf8;
+        parser.end = utf8 + numBytes;
+        ImagesInThisDocument.clear();
+
+        renderStats = RenderStats();
+        allocatedBytesAtStart = AllocationCounter::getNumBytes();
+
+        // Skip the byte order mark, if any
+        if (numBytes >= 3 && CharPointer_UTF8::isByteOrderMark(utf8))
+            parser.position += 3;
+    }
+
+    // Parse until the end of the buffer, the deadline (if not zero) or the first full screen of text.
+    // Returns true when the whole buffer has been parsed.
+    bool parseSlice(double deadline, bool stopAfterFirstScreen)
+    {
+        GSI_TRACE_SCOPE("parseSlice");
+
+        auto sliceStart = Time::getHighResolutionTicks();
 
-        textEditor->setFont(theFont);
+        EditorSink sink { *this, deadline, stopAfterFirstScreen, parser.end };
+        tokenize(parser, Comment, limits, sink);
+
+        if (parser.truncated)
+            parser.position = parser.end;
+
+        renderStats.totalMs += getElapsedMs(sliceStart);
+        return parser.position >= parser.end;
     }
 
-    // Attempt to parse some basic inline CSS
-    void parseInlineStyle(const String& inlineStyleString, bool remember = true)
+    // Where tokenize() sends what it reads when parsing straight into the TextEditor
+    struct EditorSink
     {
-        if (remember)
+        GSiHtmlTextEdit& owner;
+        double deadline;
+        bool stopAfterFirstScreen;
+        const char* bufferEnd;      // How far the content of a tag (a stylesheet) can go
+
+        void addChars(int numChars) { owner.charCounter += numChars; }
+
+        void flushText(TextBuffer& text, const char* position)
         {
-            prev_fontSize = fontSize;
-            prev_fontColor = fontColor;
-            prev_fontFace = fontFace;
+            // A live preview that went past the kept part of its previous version can't use it
+            if (owner.preview.keptStart != nullptr && position > owner.preview.keptStart)
+                owner.dropKeptPart();
+
+            // Tags come one after the other more often than not, with no text in between
+            auto insertPosition = owner.getInsertPosition();
+            if (owner.textEditor->getCaretPosition() != insertPosition)
+                owner.textEditor->setCaretPosition(insertPosition);
+
+            owner.insertText(text.toString());
+            text.clear();
         }
 
-        auto styles = StringArray::fromTokens(inlineStyleString, ";", "'");
-        for (auto style : styles)
+        bool handleTag(const HtmlStringView& tag, CharPointer_UTF8& p)
         {
-            auto pair = StringArray::fromTokens(style, ":", "'");
-            if (pair.size() < 2) continue;
-            auto key = pair[0].trim();
-            auto val = pair[1].trim();
-            //DBG("Key: " << key << " Value: " << val);
+            owner.processTag(tag, p, bufferEnd);
+
+            // Remember where each block ends while rendering a live preview, see updateHtml()
+            return owner.preview.isRecording && !owner.parser.beginEncoded && endsBlock(tag.upToFirstSpace())
+                && owner.recordBlockState(p.getAddress());
+        }
 
-            if (key == "text-decoration")
+        // Check the time (or the text height), called only every now and then as both aren't cheap
+        bool shouldStop()
+        {
+            if (owner.charCounter > owner.limits.maxOutputChars)
             {
-                if (val.contains("underline")) fontStyle |= Font::FontStyleFlags::underlined;
+                owner.parser.truncated = true;
+                return true;
             }
-            if (key == "font-weight")
+
+            if (stopAfterFirstScreen) return owner.getLaidOutTextHeight() >= owner.getHeight();
+            return deadline > 0.0 && Time::getMillisecondCounterHiRes() >= deadline;
+        }
+    };
+
+    // Read the HTML from state.position to state.end, or until the sink wants to stop. The sink gets:
+    //   addChars(n)            the number of characters added to the page (negative to take some back)
+    //   flushText(text, p)     the text collected before a tag, to be inserted and cleared
+    //   handleTag(tag, p)      each complete tag, p is right after it and may be moved, returns true to stop there
+    //   shouldStop()           checked every 256 characters
+    // The sink is either the TextEditor, or a recorder of tokens when parsing in parallel.
+    template <typename Sink>
+    static void tokenize(ParserState& state, bool& comment, const ParserLimits& limits, Sink& sink)
+    {
+        auto& beginTag = state.beginTag;
+        auto& canParseTag = state.canParseTag;
+        auto& beginEncoded = state.beginEncoded;
+        auto& canParseEncoding = state.canParseEncoding;
+        auto& renderPreFormatted = state.renderPreFormatted;
+        auto& tag = state.tag;
+        auto& code = state.code;
+        auto& output = state.output;
+        auto& lastChar = state.lastChar;
+        auto& commentStart = state.commentStart;
+
+        auto p = CharPointer_UTF8(state.position);
+        const auto end = state.end;
+        int charsSinceLastCheck = 0;
+
+        // Parse each single character in the HTML text
+        while (p.getAddress() < end)
+        {
+            if (++charsSinceLastCheck >= 256)
             {
-                if (val.contains("bold")) fontStyle |= Font::FontStyleFlags::bold;
+                charsSinceLastCheck = 0;
+                if (sink.shouldStop()) break;
             }
-            if (key == "font-size")
+
+            // Don't decode past the end of the buffer if the last sequence is truncated
+            auto lead = (uint8)*p.getAddress();
+            int sequenceLength = lead < 0x80 ? 1 : (lead < 0xe0 ? 2 : (lead < 0xf0 ? 3 : 4));
+            if (end - p.getAddress() < sequenceLength)
             {
-                if (val.contains("px")) fontSize = val.replace("px", "").getIntValue();
+                p = CharPointer_UTF8(end);
+                break;
             }
-            if (key == "font-family")
+
+            auto s = p.getAndAdvance();
+
+            // Replace CRLF with just LF
+            if (s == '\r' && p.getAddress() < end && *p == '\n') continue;
+
+            // Make sure that content in a pre-formatted paragraph passes unaltered, including HTML code, until the closing tag
+            if (renderPreFormatted)
             {
-                fontFace = val.replace("'", "");
+                // Make a tab with 4 spaces
+                if (s == '\t')
+                {
+                    output.add("   ");
+                    sink.addChars(4);
+                }
+                else
+                {
+                    output.add(s);
+                    sink.addChars(1);
+                }
+
+                if (output.endsWithIgnoreCase("</pre>"))
+                {
+                    output.removeLast(6);
+                    sink.addChars(-6);
+
+                    renderPreFormatted = false;
+                    sink.flushText(output, p.getAddress());
+
+                    tag = "/pre";
+                    canParseTag = true;
+                }
+                continue;
             }
-            if (key == "color")
+
+            // Skip white spaces at the beginning of the text
+            else
             {
-                auto col = val.replace("#", "").getHexValue32() + 0xFF000000;
-                fontColor = Colour(col);
-                textEditor->setColour(TextEditor::ColourIds::textColourId, fontColor);
+                if (s == '\t')
+                    continue;
             }
-        }
 
-        doSetFont();
+            // Catch HTML tag opening
+            if (s == '<')
+            {
+                // Inside a comment it's just part of the comment, a tag there must not be handled
+                if (comment)
+                {
+                    tag.end = p.getAddress();
+                    continue;
+                }
+
+                sink.flushText(output, p.getAddress());
+
+                beginTag = true;
+                canParseTag = false;
+                tag = { p.getAddress(), p.getAddress() };
+                continue;
+            }
+
+            // Read HTML tag or catch its closing (the tag is just a view on the source, it grows as we go)
+            if (beginTag)
+            {
+                if (s == '>')
+                {
+                    if (comment) { if (!tag.endsWith("--")) continue; else { comment = false; commentStart = nullptr; } } // Discard everything within a comment including tags
+                    beginTag = false;
+                    canParseTag = true;
+                }
+                else
+                {
+                    tag.end = p.getAddress();
+                    if (!comment && tag.startsWith("!--")) comment = true; // Detect comment start
+                    if (comment && commentStart == nullptr) commentStart = tag.start;
+
+                    // Give up on a tag or a comment that doesn't end, what follows is text again
+                    if (p.getAddress() - (comment ? commentStart : tag.start) > limits.maxTagLength)
+                    {
+                        beginTag = comment = false;
+                        commentStart = nullptr;
+                        tag.clear();
+                    }
+                    continue;
+                }
+            }
+
+            // Catch HTML-Encoded character
+            if (s == '&')
+            {
+                beginEncoded = true;
+                canParseEncoding = false;
+                code = { p.getAddress(), p.getAddress() };
+                continue;
+            }
+
+            // Read HTML-Encoding or catch encoding closure
+            if (beginEncoded)
+            {
+                if (s == ';')
+                {
+                    beginEncoded = false;
+                    canParseEncoding = true;
+                }
+                else
+                {
+                    code.end = p.getAddress();
+
+                    // Not an entity after all: the '&' is text, and what follows is read again as such
+                    if (code.length() > limits.maxEntityLength)
+                    {
+                        p = CharPointer_UTF8(code.start);
+                        beginEncoded = canParseTag = false;
+                        code.clear();
+                        tag.clear();
+
+                        lastChar = '&';
+                        output.add(lastChar);
+                        sink.addChars(1);
+                    }
+                    continue;
+                }
+            }
+
+            // Parse some common HTML-Encoded characters, they go in the output buffer with the text around them
+            if (canParseEncoding && code.isNotEmpty())
+            {
+                if (auto c = HtmlEntities::decode(code))
+                {
+                    output.add(c);
+                    sink.addChars(1);
+                }
+
+                code.clear();
+                continue;
+            }
+
+            // Parse Tags
+            if (canParseTag && tag.isNotEmpty())
+            {
+                auto stop = sink.handleTag(tag, p);
+                tag.clear();
+
+                if (stop) break;
+                continue;
+            }
+
+            // Skip multiple new lines
+            if (lastChar == '\n' && s == '\n') continue;
+
+            // Don't render white spaces at begin of new line
+            if (lastChar == '\n' && s == ' ') continue;
+
+            // Don't render multiple white spaces
+            if (lastChar == ' ' && s == ' ') continue;
+
+            // Replace new line with white space
+            lastChar = (s == '\n') ? ' ' : s;
+
+            // Add the plain characters to the output buffer
+            output.add(lastChar);
+            sink.addChars(1);
+        }
+
+        state.position = p.getAddress();
+    }
+
+    // Apply a tag to the page, p is right after the tag and moves on if the tag has content to skip
+    void processTag(const HtmlStringView& tag, CharPointer_UTF8& p, const char* end)
+    {
+        GSI_TRACE_SCOPE_DETAIL("tag", tag.toString());
+
+        auto& lastChar = parser.lastChar;
+        auto& renderPreFormatted = parser.renderPreFormatted;
+
+        auto tagName = tag.upToFirstSpace();
+        recordAnchors(tag, tagName);
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Break line
+        if (tag.startsWithIgnoreCase("br ") || tag == "br") { lastChar = '\n'; insertText("\n"); charCounter++; }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Italic
+        else if (tagName == "i" || tagName == "em") { pushStyle(tagName == "i" ? "i" : "em"); fontStyle |= Font::FontStyleFlags::italic; applyElementStyle(tag); }
+        else if (tag == "/i" || tag == "/em") { popStyle(tag == "/i" ? "i" : "em"); }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Bold
+        else if (tagName == "b" || tagName == "strong") { pushStyle(tagName == "b" ? "b" : "strong"); fontStyle |= Font::FontStyleFlags::bold; applyElementStyle(tag); }
+        else if (tag == "/b" || tag == "/strong") { popStyle(tag == "/b" ? "b" : "strong"); }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Underlined
+        else if (tagName == "u") { pushStyle("u"); fontStyle |= Font::FontStyleFlags::underlined; applyElementStyle(tag); }
+        else if (tag == "/u") { popStyle("u"); }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Anchor
+        else if (tag.startsWithIgnoreCase("a "))
+        {
+            pushStyle("a");
+            tmpHL.url.clear();
+
+            // Only links look like links, named anchors are just targets
+            if (tag.containsIgnoreCase("href"))
+            {
+                fontStyle |= Font::FontStyleFlags::underlined;
+                fontColor = linkColor;
+
+                tmpHL.url = tag.getAttribute("href").toString();
+                tmpHL.position.setStart(charCounter);
+            }
+
+            applyElementStyle(tag);
+        }
+        else if (tag == "/a")
+        {
+            popStyle("a");
+
+            if (tmpHL.url.isNotEmpty())
+            {
+                tmpHL.position.setEnd(charCounter);
+                getDocumentForWriting().links.add(tmpHL);
+                tmpHL.url.clear();
+            }
+        }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Font
+        else if (tag.startsWithIgnoreCase("font "))
+        {
+            pushStyle("font");
+
+            if (tag.containsIgnoreCase("size"))
+                fontSize = tag.getAttribute("size").getFloatValue();
+
+            if (tag.containsIgnoreCase("color"))
+                fontColor = Colour(tag.getAttribute("color").getHexValue32() + 0xFF000000);
+
+            if (tag.containsIgnoreCase("face"))
+                fontFace = tag.getAttribute("face").toString();
+
+            applyElementStyle(tag);
+        }
+        else if (tag == "/font")
+        {
+            popStyle("font");
+        }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Font size modifiers "small" and "big"
+        else if (tagName == "small")
+        {
+            pushStyle("small");
+            fontSize *= 0.75f;
+            applyElementStyle(tag);
+        }
+        else if (tagName == "big")
+        {
+            pushStyle("big");
+            fontSize *= 1.25f;
+            applyElementStyle(tag);
+        }
+        else if (tag == "/small" || tag == "/big")
+        {
+            popStyle(tag == "/small" ? "small" : "big");
+        }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Lists
+        else if (tag.startsWithIgnoreCase("ul"))
+        {
+            lastListIsOrdered = false;
+            OrderedListCounter = 1;
+            lastIndentRange.setStart(charCounter + 1);
+        }
+        else if (tag.startsWithIgnoreCase("ol"))
+        {
+            lastListIsOrdered = true;
+            OrderedListCounter = 1;
+            lastIndentRange.setStart(charCounter + 1);
+        }
+        else if (tag.startsWithIgnoreCase("li"))
+        {
+            if (useImageIdents)
+            {
+                insertText("\n"); charCounter++;
+            }
+            else
+            {
+                String indent = (lastListIsOrdered) ? "\n  " + String(OrderedListCounter) + ". " : "\n  - ";
+                insertText(indent);
+                charCounter += indent.length();
+            }
+            OrderedListCounter++;
+        }
+        else if (tag.startsWithIgnoreCase("/ul") || tag.startsWithIgnoreCase("/ol"))
+        {
+            if (useImageIdents)
+            {
+                lastIndentRange.setEnd(charCounter);
+                addListSnapshot(lastIndentRange);
+                charCounter = lastIndentRange.getStart();
+
+                String listSymbols;
+                for (int i = 1; i < OrderedListCounter; i++) listSymbols += (lastListIsOrdered) ? String(i) + ".\n" : " -\n";
+                insertText(listSymbols);
+                charCounter += listSymbols.length();
+            }
+
+            // Add newline after unordered (or ordered) list
+            lastChar = '\n'; insertText("\n"); charCounter++;
+            lastListIsOrdered = false;
+        }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Headers
+        else if (tag.startsWithIgnoreCase("h") && tag.containsAnyOf("1234"))
+        {
+            pushStyle("h");
+            auto sz = HtmlStringView(tagName.end - 1, tagName.end).getIntValue();
+            fontSize = 40 - sz * 4;
+            applyElementStyle(tag);
+        }
+        else if (tag.startsWithIgnoreCase("/h") && tag.containsAnyOf("1234"))
+        {
+            popStyle("h");
+
+            // Add double newline after header text
+            lastChar = '\n'; insertText("\n\n"); charCounter += 2;
+        }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Paragraph
+        else if (tag.startsWithIgnoreCase("p ") || tag == "p")
+        {
+            // Paragraphs can't be nested, a new one closes the previous one
+            popStyle("p");
+            pushStyle("p");
+
+            // Add newline before paragraph
+            lastChar = '\n'; insertText("\n"); charCounter++;
+
+            applyElementStyle(tag);
+        }
+        else if (tag == "/p")
+        {
+            popStyle("p");
+
+            // Add newline after paragraph
+            lastChar = '\n'; insertText("\n"); charCounter++;
+        }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Span
+        else if (tag.startsWithIgnoreCase("span ") || tag == "span")
+        {
+            pushStyle("span");
+            applyElementStyle(tag);
+        }
+        else if (tag == "/span")
+        {
+            popStyle("span");
+        }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Pre-formatted
+        else if (tag.startsWithIgnoreCase("pre"))
+        {
+            renderPreFormatted = true;
+
+            pushStyle("pre");
+            fontStyle = Font::FontStyleFlags::plain;
+            fontSize = 12;
+            fontFace = Font::getDefaultMonospacedFontName();
+            applyElementStyle(tag);
+        }
+        else if (tag == "/pre")
+        {
+            renderPreFormatted = false;
+            popStyle("pre");
+        }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Stylesheet, compiled once and skipped, its content isn't text to show
+        else if (tagName.equalsIgnoreCase("style"))
+        {
+            pageStyleSheet.addRules(skipStyleContent(p, end));
+        }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Body, only for its style
+        else if (tagName.equalsIgnoreCase("body"))
+        {
+            pushStyle("body");
+            applyElementStyle(tag);
+        }
+        else if (tagName.equalsIgnoreCase("/body"))
+        {
+            popStyle("body");
+        }
+
+        //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+        // Image
+        else if (tag.startsWithIgnoreCase("img "))
+        {
+            auto ImgSrc = tag.getAttribute("src").toString();
+
+            GSI_TRACE_SCOPE_DETAIL("image", ImgSrc);
+
+            auto imageStart = Time::getHighResolutionTicks();
+            auto img = loadImage(ImgSrc);
+            renderStats.imageDecodeMs += getElapsedMs(imageStart);
+
+            // Found but not local, it's loaded in the background
+            bool isPending = !img.isValid() && resources->locate(ImgSrc).isNotEmpty();
+
+            if (img.isValid() || isPending)
+            {
+                int lastFontHeight = textEditor->getFont().getHeight();
+                int w = img.getWidth();
+                int h = img.getHeight();
+
+                if (isPending)
+                {
+                    w = tag.getAttribute("width").getIntValue();
+                    h = tag.getAttribute("height").getIntValue();
+                    if (w <= 0) w = h > 0 ? h : pendingImageSize;
+                    if (h <= 0) h = w;
+                }
+
+                // Resize image (set width, keep aspect ratio)
+                if (tag.containsIgnoreCase("width"))
+                {
+                    auto val = tag.getAttribute("width").getIntValue();
+                    if (val > 0)
+                    {
+                        auto ratio = (float)h / (float)w;
+                        w = jmin(val, limits.maxImageSize);
+                        h = w * ratio;
+                    }
+                }
+
+                // Huge images are shown smaller, with the same aspect ratio
+                if (w > limits.maxImageSize || h > limits.maxImageSize)
+                {
+                    auto scale = jmin((float)limits.maxImageSize / (float)w, (float)limits.maxImageSize / (float)h);
+                    w = jmax(1, roundToInt((float)w * scale));
+                    h = jmax(1, roundToInt((float)h * scale));
+                }
+
+                addImage(ImgSrc, img, w, h);
+
+                // Now calculate the amount of break lines needed to move the text right below the image using the last font height
+                int shiftY = round((float)h / (float)jmax(1, lastFontHeight));
+                for (int i = 0; i < shiftY; i++)
+                {
+                    lastChar = '\n'; insertText("\n"); charCounter++;
+                }
+            }
+
+            else
+            {
+                String errMsg("[NOT FOUND: " + ImgSrc + "]\n");
+                insertText(errMsg);
+                charCounter += errMsg.length();
+            }
+        }
+    }
+
+    // The content of a <style> block, p is right after its opening tag and moves past the closing one
+    static HtmlStringView skipStyleContent(CharPointer_UTF8& p, const char* end)
+    {
+        auto content = HtmlStringView(p.getAddress(), end);
+        auto closing = content.indexOfIgnoreCase("</style");
+        if (closing >= 0) content.end = content.start + closing;
+
+        auto* next = content.end;
+        while (next < end && *next != '>') next++;
+        p = CharPointer_UTF8(next < end ? next + 1 : end);
+
+        return content;
+    }
+
+    //==============================================================================
+    // Parallel parsing, see setParallelParsing(). The page is split into chunks right after the tags that
+    // start a new line, outside comments, entities, <pre> and <style>, so that each chunk starts in a known
+    // state. The chunks are tokenized on the shared HtmlThreadPool, no more than parallelParsingThreads at
+    // once, guessing how each tag changes the state of the parser. Then the tokens are applied in order here,
+    // where the tags are handled for real. Wherever a guess turns out wrong, the rest of that chunk is parsed
+    // the normal way, so the page is always the same.
+
+    size_t parallelParsingThreshold = 0;
+    int parallelParsingThreads = 1;
+
+    struct Token
+    {
+        HtmlStringView tag;             // Empty for text
+        String text;
+        int numChars = 0;
+        const char* tagEnd = nullptr;   // Where the tag was closed
+        const char* after = nullptr;    // Where the parser goes on after the tag
+        juce_wchar lastChar = 0;        // The state of the parser after the token
+        bool preFormatted = false;
+    };
+
+    struct Chunk
+    {
+        const char* start;
+        const char* end;
+        juce_wchar startLastChar;
+        Array<Token> tokens;
+        bool isUsable = false;
+    };
+
+    // Where tokenize() sends what it reads when tokenizing a chunk
+    struct TokenRecorder
+    {
+        ParserState& state;
+        Array<Token>& tokens;
+        int pendingChars = 0;
+        bool isExact = true;
+
+        void addChars(int numChars) { pendingChars += numChars; }
+
+        void flushText(TextBuffer& text, const char*)
+        {
+            // The end of a <pre> block is seen here, even when it's empty
+            auto preFormatted = tokens.isEmpty() ? false : tokens.getReference(tokens.size() - 1).preFormatted;
+
+            if (!text.isEmpty() || pendingChars != 0 || state.renderPreFormatted != preFormatted)
+            {
+                Token token;
+                token.text = text.toString();
+                token.numChars = pendingChars;
+                token.lastChar = state.lastChar;
+                token.preFormatted = state.renderPreFormatted;
+                tokens.add(std::move(token));
+            }
+
+            pendingChars = 0;
+            text.clear();
+        }
+
+        bool handleTag(const HtmlStringView& tag, CharPointer_UTF8& p)
+        {
+            // Characters counted but not flushed yet (an entity closed after the tag) come
+            // before the tag in the page, tokens can't tell that
+            if (pendingChars != 0 || !state.output.isEmpty())
+            {
+                isExact = false;
+                return true;
+            }
+
+            Token token;
+            token.tag = tag;
+            token.tagEnd = p.getAddress();
+
+            predictTag(tag, p, state);
+
+            token.after = p.getAddress();
+            token.lastChar = state.lastChar;
+            token.preFormatted = state.renderPreFormatted;
+            tokens.add(std::move(token));
+            return false;
+        }
+
+        bool shouldStop() { return false; }
+    };
+
+    // Tags after which the parser is at the beginning of a new line, see processTag()
+    static bool startsNewLine(const HtmlStringView& tag)
+    {
+        return tag.startsWithIgnoreCase("br ") || tag == "br" || tag == "/p" || tag.startsWithIgnoreCase("p ") || tag == "p"
+            || tag.startsWithIgnoreCase("/ul") || tag.startsWithIgnoreCase("/ol")
+            || (tag.startsWithIgnoreCase("/h") && tag.containsAnyOf("1234"));
+    }
+
+    // How a tag is expected to change the state of the parser, without handling it
+    static void predictTag(const HtmlStringView& tag, CharPointer_UTF8& p, ParserState& state)
+    {
+        if (startsNewLine(tag))
+            state.lastChar = '\n';
+        else if (tag.startsWithIgnoreCase("img "))
+            state.lastChar = '\n';  // Unless the image isn't found, or is too small
+        else if (tag.startsWithIgnoreCase("pre"))
+            state.renderPreFormatted = true;
+        else if (tag == "/pre")
+            state.renderPreFormatted = false;
+        else if (tag.upToFirstSpace().equalsIgnoreCase("style"))
+            skipStyleContent(p, state.end);
+    }
+
+    static void tokenizeChunk(Chunk& chunk, const ParserLimits& limits)
+    {
+        ParserState state;
+        state.position = chunk.start;
+        state.end = chunk.end;
+        state.lastChar = chunk.startLastChar;
+
+        bool comment = false;
+        TokenRecorder recorder { state, chunk.tokens };
+        tokenize(state, comment, limits, recorder);
+
+        // Whatever the chunk ends with must be complete, otherwise it's parsed the normal way
+        chunk.isUsable = recorder.isExact && state.position >= chunk.end && !comment
+                      && !state.beginTag && !state.beginEncoded && !state.renderPreFormatted;
+
+        if (chunk.isUsable)
+            recorder.flushText(state.output, chunk.end);
+    }
+
+    // Where the HTML can be split: right after a tag that starts a new line, outside comments, <pre>, <style>
+    // and entities, at least chunkSize bytes apart. Tags are read the way tokenize() does (a '<' starts a new
+    // tag even inside another one or a comment). A wrong split isn't a problem, just slower: see parseInParallel().
+    static Array<const char*> findChunkBoundaries(const char* start, const char* end, size_t chunkSize)
+    {
+        Array<const char*> boundaries;
+        auto nextBoundary = chunkSize;
+        bool entityIsOpen = false;
+        auto* p = start;
+
+        while (p < end && (size_t)(end - start) > nextBoundary)
+        {
+            auto c = *p++;
+
+            if (c == '&') { entityIsOpen = true; continue; }
+            if (c == ';') { entityIsOpen = false; continue; }
+            if (c != '<') continue;
+
+            // Find the end of the tag, or of the comment
+            auto* tagStart = p;
+            bool isComment = false;
+            while (p < end)
+            {
+                auto t = *p++;
+                if (t == '<') tagStart = p;
+                else if (t == '>' && (!isComment || (p - tagStart >= 3 && p[-2] == '-' && p[-3] == '-'))) break;
+                else if (!isComment && p - tagStart == 3 && HtmlStringView(tagStart, p).startsWith("!--")) isComment = true;
+            }
+
+            if (p >= end || p[-1] != '>') break;
+
+            auto tag = HtmlStringView(tagStart, p - 1);
+            if (isComment) continue;
+
+            if (tag.startsWithIgnoreCase("pre"))
+            {
+                auto closing = HtmlStringView(p, end).indexOfIgnoreCase("</pre>");
+                if (closing < 0) break;
+                p += closing + 6;
+            }
+            else if (tag.upToFirstSpace().equalsIgnoreCase("style"))
+            {
+                auto next = CharPointer_UTF8(p);
+                skipStyleContent(next, end);
+                p = next.getAddress();
+            }
+            else if (!entityIsOpen && (size_t)(p - start) >= nextBoundary && startsNewLine(tag))
+            {
+                boundaries.add(p);
+                nextBoundary = (size_t)(p - start) + chunkSize;
+            }
+        }
+
+        return boundaries;
+    }
+
+    // Like parseSlice(0.0, false), the tokenizing is spread over several threads
+    void parseInParallel()
+    {
+        GSI_TRACE_SCOPE("parseInParallel");
+
+        auto parallelStart = Time::getHighResolutionTicks();
+        auto totalMsBefore = renderStats.totalMs;
+        auto* bufferEnd = parser.end;
+
+        // A few chunks per thread, so that they all finish at about the same time
+        auto numThreads = jmax(1, parallelParsingThreads);
+        auto chunkSize = jmax((size_t)64 * 1024, (size_t)(bufferEnd - parser.position) / (size_t)(numThreads * 4));
+
+        OwnedArray<Chunk> chunks;
+        auto* chunkStart = parser.position;
+        for (auto* boundary : findChunkBoundaries(parser.position, bufferEnd, chunkSize))
+        {
+            chunks.add(new Chunk { chunkStart, boundary, '\n' });
+            chunkStart = boundary;
+        }
+        chunks.add(new Chunk { chunkStart, bufferEnd, '\n' });
+        chunks[0]->startLastChar = parser.lastChar;
+
+        {
+            SharedResourcePointer<HtmlThreadPool> pool;
+            HtmlJobBatch batch(*pool);
+
+            for (auto* chunk : chunks)
+            {
+                batch.waitUntilAtMost(numThreads - 1);
+                batch.add([chunk, chunkLimits = limits] { tokenizeChunk(*chunk, chunkLimits); });
+            }
+
+            batch.waitForAll();
+        }
+
+        // Then the tokens are applied in order, as the state of the parser depends on everything before
+        for (auto* chunk : chunks)
+        {
+            if (parser.truncated) break;
+
+            // A stylesheet may have been skipped past the end of the previous chunk
+            if (parser.position >= chunk->end) continue;
+
+            parser.end = chunk->end;
+
+            if (chunk->isUsable && parser.position == chunk->start && isAtChunkStart(*chunk))
+                applyTokens(*chunk, bufferEnd);
+            else
+                parseChunk(bufferEnd);
+        }
+
+        parser.end = bufferEnd;
+        if (parser.truncated) parser.position = bufferEnd;
+
+        renderStats.totalMs = totalMsBefore + getElapsedMs(parallelStart);
+    }
+
+    bool isAtChunkStart(const Chunk& chunk) const
+    {
+        return !parser.beginTag && !parser.beginEncoded && !parser.renderPreFormatted && !Comment
+            && parser.tag.isEmpty() && parser.output.isEmpty() && parser.lastChar == chunk.startLastChar;
+    }
+
+    void applyTokens(const Chunk& chunk, const char* bufferEnd)
+    {
+        for (auto& token : chunk.tokens)
+        {
+            if (token.tag.isEmpty())
+            {
+                textEditor->setCaretPosition(getInsertPosition());
+                insertText(token.text);
+                charCounter += token.numChars;
+                parser.lastChar = token.lastChar;
+                parser.renderPreFormatted = token.preFormatted;
+
+                if (charCounter > limits.maxOutputChars)
+                {
+                    parser.truncated = true;
+                    return;
+                }
+                continue;
+            }
+
+            auto p = CharPointer_UTF8(token.tagEnd);
+            processTag(token.tag, p, bufferEnd);
+
+            // Guessed wrong, parse the rest of the chunk the normal way
+            if (p.getAddress() != token.after || parser.lastChar != token.lastChar || parser.renderPreFormatted != token.preFormatted)
+            {
+                parser.position = p.getAddress();
+                parseChunk(bufferEnd);
+                return;
+            }
+        }
+
+        parser.position = chunk.end;
+    }
+
+    // Parse up to parser.end, where the chunk ends, tags can still look further
+    void parseChunk(const char* bufferEnd)
+    {
+        EditorSink sink { *this, 0.0, false, bufferEnd };
+        tokenize(parser, Comment, limits, sink);
+    }
+
+    // Insert the text collected so far, unless we're in the middle of a pre-formatted block
+    // where the buffer is still needed to catch the closing tag
+    void flushPendingOutput()
+    {
+        if (parser.renderPreFormatted || parser.output.isEmpty()) return;
+
+        textEditor->setCaretPosition(getInsertPosition());
+        insertText(parser.output.toString());
+        parser.output.clear();
+    }
+
+    void finishParsing()
+    {
+        GSI_TRACE_SCOPE("finishParsing");
+
+        auto finishStart = Time::getHighResolutionTicks();
+
+        // Print the remaining output buffer
+        textEditor->setCaretPosition(getInsertPosition());
+        insertText(parser.output.toString());
+
+        // A page that was too long says where it was cut
+        if (parser.truncated)
+        {
+            String note("\n[TRUNCATED]\n");
+            insertText(note);
+            charCounter += note.length();
+            renderStats.truncated = true;
+        }
+
+        parser = ParserState();
+        progressiveSource.clear();
+        progressiveMappedFile.reset();
+
+        getDocumentForWriting().length = charCounter;
+        totalTextHeight = getLaidOutTextHeight();
+
+        renderStats.totalMs += getElapsedMs(finishStart);
+        renderStats.tokenizeMs = jmax(0.0, renderStats.totalMs - renderStats.styleMs - renderStats.insertMs - renderStats.layoutMs - renderStats.imageDecodeMs);
+        if (AllocationCounter::isEnabled())
+            renderStats.bytesAllocated = AllocationCounter::getNumBytes() - allocatedBytesAtStart;
+
+        DBG("Text Height: " << totalTextHeight);
+        DBG("Render stats: " << renderStats.toString());
+
+        if (mobileStyle) resized();
+
+        if (diskCacheToStore != nullptr)
+        {
+            GSI_TRACE_SCOPE("storeInDiskCache");
+            diskCacheToStore->store(fileToStore, settingsToStore, *document);
+            diskCacheToStore = nullptr;
+        }
+
+        if (onParsingComplete != nullptr)
+            onParsingComplete();
+    }
+
+    void timerCallback() override
+    {
+        GSI_TRACE_SCOPE("progressiveSlice");
+
+        // Keep the reader where they are, inserting text moves the caret and scrolls the editor
+        auto* viewport = getEditorViewport();
+        auto viewPosition = viewport != nullptr ? viewport->getViewPosition() : juce::Point<int>();
+        auto caretPosition = textEditor->getCaretPosition();
+
+        if (parseSlice(Time::getMillisecondCounterHiRes() + progressiveTimeSlice, false))
+        {
+            stopTimer();
+            finishParsing();
+        }
+        else
+        {
+            flushPendingOutput();
+            totalTextHeight = getLaidOutTextHeight();
+            if (mobileStyle) resized();
+        }
+
+        textEditor->setCaretPosition(caretPosition);
+        if (viewport != nullptr) viewport->setViewPosition(viewPosition);
+    }
+
+    // The TextEditor keeps its text in a private Viewport, which is its first child
+    Viewport* getEditorViewport()
+    {
+        return dynamic_cast<Viewport*>(textEditor->getChildComponent(0));
+    }
+
+    // Where a character is, from the top of the page (not of the visible area)
+    int getTextY(int index)
+    {
+        auto bounds = textEditor->getTextBounds({ index, index + 1 }).getBounds();
+        auto* viewport = getEditorViewport();
+
+        // In mobile style the editor is as tall as the page, otherwise it scrolls the text itself
+        return bounds.getY() + (mobileStyle || viewport == nullptr ? 0 : viewport->getViewPositionY());
+    }
+
+    // Targets of fragment links: <a name="..."> and the id of any element
+    void recordAnchors(const HtmlStringView& tag, const HtmlStringView& tagName)
+    {
+        if (tagName.startsWith("/") || tagName.startsWith("!")) return;
+
+        auto addAnchor = [this](HtmlStringView name)
+        {
+            if (name.isNotEmpty())
+                getDocumentForWriting().anchors[name.toString()] = charCounter;
+        };
+
+        if (tag.containsIgnoreCase("id="))
+            addAnchor(tag.getAttribute("id"));
+
+        if (tagName.equalsIgnoreCase("a") && tag.containsIgnoreCase("name="))
+            addAnchor(tag.getAttribute("name"));
+    }
+
+    // Images come from the resource provider, by default the resources then the working directory
+    SharedResourcePointer<HtmlResources> resources;
+    static constexpr int pendingImageSize = 100; // Width and height of an image that isn't loaded yet, if the tag doesn't say
+
+    // Only local images are loaded here, on the message thread. The others are shown once loadImageLater()
+    // has them, in a component of the size given by the <img> tag meanwhile.
+    Image loadImage(const String& ImgSrc)
+    {
+        return resources->loadLocalImage(ImgSrc);
+    }
+
+    void loadImageLater(ImageComponent* cmp)
+    {
+        Component::SafePointer<ImageComponent> safeImage(cmp);
+
+        resources->loadImageAsync(cmp->getName(), [safeImage](Image image)
+        {
+            if (safeImage != nullptr && image.isValid())
+                safeImage->setImage(image);
+        });
+    }
+
+    //==============================================================================
+    // TextEditor calls made while parsing go through these, to record them in the document
+    // and to keep the render statistics
+
+    RenderStats renderStats;
+    int64 allocatedBytesAtStart = 0;
+
+    static double getElapsedMs(int64 startTicks)
+    {
+        return Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks) * 1000.0;
+    }
+
+    // Shared documents are never modified, this view gets its own copy before adding anything
+    HtmlDocument& getDocumentForWriting()
+    {
+        if (document->getReferenceCount() > 1)
+            document = new HtmlDocument(*document);
+
+        return *document;
+    }
+
+    void addOperation(HtmlDocument::OperationType type, int index, int position = 0)
+    {
+        auto& doc = getDocumentForWriting();
+        doc.operations.add({ type, index, position });
+        applyOperation(doc, doc.operations.getLast());
+    }
+
+    void insertText(const String& text)
+    {
+        if (text.isEmpty()) return;
+
+        auto& doc = getDocumentForWriting();
+        doc.texts.add(text);
+        addOperation(HtmlDocument::OperationType::text, doc.texts.size() - 1, textEditor->getCaretPosition());
+    }
+
+    void setTextColour(const Colour& colour)
+    {
+        appliedStyle.colour = colour;
+        appliedColourIsValid = true;
+
+        auto& doc = getDocumentForWriting();
+        doc.colours.add(colour);
+        addOperation(HtmlDocument::OperationType::colour, doc.colours.size() - 1);
+    }
+
+    // The face is what makeFont() needs to make the same font again when a saved document is loaded
+    void setEditorFont(const Font& font, const String& face = {})
+    {
+        auto& doc = getDocumentForWriting();
+        doc.fonts.add(font);
+        doc.fontFaces.add(face.isNotEmpty() ? face : font.getTypefaceName());
+        addOperation(HtmlDocument::OperationType::font, doc.fonts.size() - 1);
+    }
+
+    void addImage(const String& source, const Image& image, int width, int height)
+    {
+        auto& doc = getDocumentForWriting();
+        doc.images.add({ source, image, width, height });
+        addOperation(HtmlDocument::OperationType::image, doc.images.size() - 1);
+    }
+
+    void addListSnapshot(Range<int> range)
+    {
+        auto& doc = getDocumentForWriting();
+        doc.listRanges.add(range);
+        addOperation(HtmlDocument::OperationType::listSnapshot, doc.listRanges.size() - 1);
+    }
+
+    void applyOperation(const HtmlDocument& doc, const HtmlDocument::Operation& op)
+    {
+        auto start = Time::getHighResolutionTicks();
+
+        switch (op.type)
+        {
+            case HtmlDocument::OperationType::text:
+            {
+                GSI_TRACE_SCOPE("insertText");
+
+                if (textEditor->getCaretPosition() != op.position)
+                    textEditor->setCaretPosition(op.position);
+
+                textEditor->insertTextAtCaret(doc.texts[op.index]);
+                renderStats.insertMs += getElapsedMs(start);
+                renderStats.insertTextCalls++;
+                break;
+            }
+
+            case HtmlDocument::OperationType::font:
+                textEditor->setFont(doc.fonts.getReference(op.index));
+                renderStats.styleMs += getElapsedMs(start);
+                break;
+
+            case HtmlDocument::OperationType::colour:
+                textEditor->setColour(TextEditor::ColourIds::textColourId, doc.colours[op.index]);
+                renderStats.styleMs += getElapsedMs(start);
+                break;
+
+            case HtmlDocument::OperationType::image:
+            {
+                const auto& entry = doc.images.getReference(op.index);
+                ImagesInThisDocument.add(entry.source);
+
+                auto* cmp = ImageComponents.add(new ImageComponent(entry.source));
+                cmp->setImage(entry.image.isValid() ? entry.image : loadImage(entry.source));
+                if (!cmp->getImage().isValid()) loadImageLater(cmp);
+
+                // Set Image size and position
+                int lastFontHeight = textEditor->getFont().getHeight();
+                int x = textEditor->getLeftIndent();
+                int y = getLaidOutTextHeight() - lastFontHeight * 2;
+                cmp->setBounds(x, y, entry.width, entry.height);
+
+                // Now this is tricky! There's no way to get the viewport that contains the text in a TextEditor.
+                // This method digs into the component until reaching the viewport.
+                // Works with Juce 6.1.6 but may break if the class is modified in future versions of Juce.
+                textEditor->getChildComponent(0)->getChildComponent(0)->getChildComponent(0)->addAndMakeVisible(cmp);
+                break;
+            }
+
+            case HtmlDocument::OperationType::listSnapshot:
+            {
+                auto range = doc.listRanges[op.index];
+                textEditor->setBounds(textEditor->getBounds().withHeight(getLaidOutTextHeight()));
+                auto b = textEditor->getTextBounds(range).getBounds();
+                auto* cmp = new ImageComponent(); ImageComponents.add(cmp);
+                cmp->setImage(textEditor->createComponentSnapshot(b));
+                cmp->setBounds(b.translated(25, 0));
+                textEditor->getChildComponent(0)->getChildComponent(0)->getChildComponent(0)->addAndMakeVisible(cmp);
+
+                textEditor->setHighlightedRegion(range); textEditor->cut();
+                break;
+            }
+        }
+    }
+
+    // Build the page from the document, without parsing anything
+    void replayDocument()
+    {
+        GSI_TRACE_SCOPE("replayDocument");
+
+        auto start = Time::getHighResolutionTicks();
+        renderStats = RenderStats();
+
+        textEditor->clear();
+        ImageComponents.clear();
+        ImagesInThisDocument.clear();
+
+        for (auto& op : document->operations)
+            applyOperation(*document, op);
+
+        charCounter = document->length;
+        appliedFontIsValid = appliedColourIsValid = false; // The editor now has the document's last style
+        totalTextHeight = getLaidOutTextHeight();
+        renderStats.totalMs = getElapsedMs(start);
+
+        if (mobileStyle) resized();
+    }
+
+    int getLaidOutTextHeight()
+    {
+        auto start = Time::getHighResolutionTicks();
+        auto height = textEditor->getTextHeight();
+        renderStats.layoutMs += getElapsedMs(start);
+        return height;
+    }
+
+    //==============================================================================
+    // Text style. Elements that change it push the current style when they open and pop it when
+    // they close, and the TextEditor is only told about a font or colour that actually changed.
+
+    struct StyleStackEntry
+    {
+        const char* element;
+        TextStyle style;
+    };
+
+    Array<StyleStackEntry> styleStack;
+    TextStyle appliedStyle;
+    bool appliedFontIsValid = false, appliedColourIsValid = false;
+
+    TextStyle getCurrentStyle() const
+    {
+        return { fontFace, fontSize, fontColor, fontStyle };
+    }
+
+    void setCurrentStyle(const TextStyle& style)
+    {
+        fontFace = style.face;
+        fontSize = style.size;
+        fontColor = style.colour;
+        fontStyle = style.flags;
+    }
+
+    void pushStyle(const char* element)
+    {
+        // Elements left open by a broken page mustn't make the stack grow forever
+        if (styleStack.size() >= jmax(1, limits.maxNestingDepth))
+            styleStack.removeRange(0, styleStack.size() - jmax(1, limits.maxNestingDepth) + 1);
+
+        styleStack.add({ element, getCurrentStyle() });
+    }
+
+    // Restore the style from before the last element with this name was opened, closing any element
+    // left open inside it. Closing an element that isn't open does nothing.
+    void popStyle(const char* element)
+    {
+        for (int i = styleStack.size(); --i >= 0;)
+        {
+            if (strcmp(styleStack.getReference(i).element, element) == 0)
+            {
+                setCurrentStyle(styleStack.getReference(i).style);
+                styleStack.removeRange(i, styleStack.size() - i);
+                applyStyle();
+                return;
+            }
+        }
+    }
+
+    void applyStyle()
+    {
+        if (!appliedFontIsValid || fontFace != appliedStyle.face || fontSize != appliedStyle.size || fontStyle != appliedStyle.flags)
+            doSetFont();
+
+        if (!appliedColourIsValid || fontColor != appliedStyle.colour)
+            setTextColour(fontColor);
+    }
+
+    //==============================================================================
+    // Typefaces from the local resource providers, shared by all the instances and created only once.
+    // They are looked for while parsing on the message thread, so never over the network.
+    // Fonts that aren't in the resources are cached too (with a null typeface), so that the
+    // resources are only searched once for each face.
+
+    struct CachedTypeface
+    {
+        Typeface::Ptr typeface;
+        HtmlResource::Ptr data; // Kept for the typeface, which may use it in place
+        int dataSize = 0;
+    };
+
+    static HashMap<String, CachedTypeface>& getTypefaceCache()
+    {
+        static HashMap<String, CachedTypeface> cache;
+        return cache;
+    }
+
+    static CriticalSection& getTypefaceCacheLock()
+    {
+        static CriticalSection lock;
+        return lock;
+    }
+
+    // Views are only made on the message thread in this application, but the batch renderer and the tile
+    // exporter keep background threads busy next to them: the count and the cache (under its lock) are safe anyway
+    static std::atomic<int>& getNumInstances()
+    {
+        static std::atomic<int> numInstances { 0 };
+        return numInstances;
+    }
+
+    Typeface::Ptr getEmbeddedTypeface(const String& face)
+    {
+        const ScopedLock sl(getTypefaceCacheLock());
+        auto& cache = getTypefaceCache();
+
+        if (cache.contains(face))
+            return cache[face].typeface;
+
+        CachedTypeface entry;
+        if (auto data = resources->fetchLocal(face))
+        {
+            entry.typeface = Typeface::createSystemTypefaceFor(data->getData(), data->getSize());
+            entry.data = data;
+            entry.dataSize = (int)data->getSize();
+            renderStats.typefaceCreations++;
+        }
+
+        cache.set(face, entry);
+        return entry.typeface;
+    }
+
+    // Forget the typefaces that no Font uses anymore
+    static void releaseUnusedTypefaces()
+    {
+        const ScopedLock sl(getTypefaceCacheLock());
+        auto& cache = getTypefaceCache();
+
+        StringArray unused;
+        for (HashMap<String, CachedTypeface>::Iterator i(cache); i.next();)
+            if (i.getValue().typeface != nullptr && i.getValue().typeface->getReferenceCount() == 1)
+                unused.add(i.getKey());
+
+        for (auto& face : unused)
+            cache.remove(face);
+    }
+
+    static void clearTypefaceCache()
+    {
+        const ScopedLock sl(getTypefaceCacheLock());
+        getTypefaceCache().clear();
+    }
+
+    void doSetFont()
+    {
+        GSI_TRACE_SCOPE_DETAIL("doSetFont", fontFace);
+
+        auto start = Time::getHighResolutionTicks();
+        renderStats.doSetFontCalls++;
+
+        //textEditor->setFont(Font(fontFace, fontSize, fontStyle));
+
+        auto theFont = makeFont(fontFace, jlimit(1.f, limits.maxFontSize, fontSize), fontStyle);
+
+        renderStats.styleMs += getElapsedMs(start);
+        setEditorFont(theFont, fontFace);
+
+        appliedStyle.face = fontFace;
+        appliedStyle.size = fontSize;
+        appliedStyle.flags = fontStyle;
+        appliedFontIsValid = true;
+    }
+
+    // A font from the resources if there's one with that name, otherwise from the system
+    Font makeFont(const String& face, float size, int styleFlags)
+    {
+        auto theFont = Font(face, size, styleFlags);
+
+        auto fontHeight = size;
+        if (auto typeface = getEmbeddedTypeface(face))
+        {
+            theFont = Font(typeface);
+            //#if JUCE_MAC || JUCE_IOS
+            //fontHeight *= 0.75f; // Fonts look bigger on iOS and Mac OS!
+            //#endif
+        }
+
+        theFont.setHeight(fontHeight);
+        theFont.setStyleFlags(styleFlags);
+        return theFont;
+    }
+
+    // Apply the stylesheet rules that match an element, then its inline CSS, on top of the style the
+    // element already set. The caller pushes the style first, so that it's restored when the element is closed.
+    void applyElementStyle(const HtmlStringView& tag)
+    {
+        HtmlStringView attributes;
+        auto tagName = tag.upToFirstSpace(&attributes);
+
+        HtmlStyle style;
+        bool hasSharedRules = sharedStyleSheet != nullptr && !sharedStyleSheet->isEmpty();
+
+        if (hasSharedRules || !pageStyleSheet.isEmpty())
+        {
+            auto classes = attributes.getAttribute("class");
+            auto id = attributes.getAttribute("id");
+
+            if (hasSharedRules) sharedStyleSheet->resolve(tagName, classes, id, style);
+            pageStyleSheet.resolve(tagName, classes, id, style);
+        }
+
+        if (attributes.containsIgnoreCase("style"))
+            style.overrideWith(HtmlStyle::parse(attributes.getAttribute("style")));
+
+        style.applyTo(fontFace, fontSize, fontColor, fontStyle);
+        applyStyle();
+    }
+
+    //==============================================================================
+    // Live preview. While rendering, the parser records its state at the end of each block, which is
+    // enough to start parsing again from there. An update parses from the last block before the change,
+    // and stops as soon as it reaches the first block after it in the same state as before: the rest of
+    // the page is kept in the TextEditor as it is, and only moved in the document.
+
+    struct BlockState
+    {
+        size_t offset = 0;          // Bytes of HTML parsed so far
+        int charCounter = 0;
+        int textLength = 0;         // Characters in the TextEditor
+        int numOperations = 0, numTexts = 0, numFonts = 0, numColours = 0, numImages = 0, numListRanges = 0, numLinks = 0;
+        int numImageComponents = 0;
+
+        TextStyle style {}, appliedStyle {};
+        bool fontIsApplied = false, colourIsApplied = false;
+        Array<StyleStackEntry> styleStack;
+        juce_wchar lastChar = 0;
+        int orderedListCounter = 0;
+        bool lastListIsOrdered = false;
+        Range<int> indentRange;
+        HtmlDocument::Link openLink;
+
+        // Parsing the same HTML from either state gives the same result
+        bool continuesLike(const BlockState& other) const
+        {
+            if (!(style == other.style && appliedStyle == other.appliedStyle && fontIsApplied == other.fontIsApplied
+                  && colourIsApplied == other.colourIsApplied && lastChar == other.lastChar && orderedListCounter == other.orderedListCounter
+                  && lastListIsOrdered == other.lastListIsOrdered && openLink.url == other.openLink.url
+                  && styleStack.size() == other.styleStack.size()))
+                return false;
+
+            for (int i = 0; i < styleStack.size(); i++)
+                if (strcmp(styleStack.getReference(i).element, other.styleStack.getReference(i).element) != 0
+                    || !(styleStack.getReference(i).style == other.styleStack.getReference(i).style))
+                    return false;
+
+            return true;
+        }
+    };
+
+    struct LivePreview
+    {
+        String source;                      // The HTML shown, the parser's views point into it
+        TextStyle initialStyle {};
+        Array<BlockState> states;           // At the end of each block, in the order of the HTML
+        BlockState endState;
+        bool isRecording = false;
+
+        // While updating: the previous version, and the part at its end that may be kept
+        HtmlDocument::Ptr previousDocument;
+        Array<BlockState> previousStates;
+        BlockState previousEndState;
+        int previousTextHeight = 0;
+        int restartCharCounter = 0;
+        int keptState = -1;                 // In previousStates
+        const char* keptStart = nullptr;    // Where the kept part starts in the new HTML
+        int keptTextLength = 0, numKeptImageComponents = 0;
+        bool keptPartReached = false;
+    } preview;
+
+    // Render the whole page
+    void renderPreview(const String& html)
+    {
+        auto style = preview.states.isEmpty() ? getCurrentStyle() : preview.initialStyle;
+
+        Reset();
+        setCurrentStyle(style);
+        doSetFont();
+        setTextColour(fontColor);
+        recordSource({ File(), html, nullptr, 0 });
+
+        preview.source = html;
+        preview.initialStyle = style;
+
+        beginParsing(html.toRawUTF8(), html.getNumBytesAsUTF8());
+        preview.states.add(captureBlockState(parser.position));
+        parsePreview();
+        preview.endState = captureBlockState(parser.end);
+        finishParsing();
+    }
+
+    void parsePreview()
+    {
+        preview.isRecording = true;
+        parseSlice(0.0, false);
+        preview.isRecording = false;
+
+        if (!preview.keptPartReached && preview.keptStart != nullptr)
+            dropKeptPart();
+    }
+
+    // Where the parser inserts text: at the end of the page, or before the kept part while updating a preview
+    int getInsertPosition()
+    {
+        return textEditor->getTotalNumChars() - preview.keptTextLength;
+    }
+
+    // Tags after which the state is recorded
+    static bool endsBlock(const HtmlStringView& tagName)
+    {
+        if (tagName.length() == 3 && tagName.startsWithIgnoreCase("/h"))
+            return tagName.end[-1] >= '1' && tagName.end[-1] <= '6';
+
+        return tagName.equalsIgnoreCase("p") || tagName.equalsIgnoreCase("/p") || tagName.equalsIgnoreCase("/ul")
+            || tagName.equalsIgnoreCase("/ol") || tagName.equalsIgnoreCase("/pre");
+    }
+
+    BlockState captureBlockState(const char* position)
+    {
+        BlockState state;
+        state.offset = (size_t)(position - preview.source.toRawUTF8());
+        state.charCounter = charCounter;
+        state.textLength = getInsertPosition();
+
+        state.numOperations = document->operations.size();
+        state.numTexts = document->texts.size();
+        state.numFonts = document->fonts.size();
+        state.numColours = document->colours.size();
+        state.numImages = document->images.size();
+        state.numListRanges = document->listRanges.size();
+        state.numLinks = document->links.size();
+        state.numImageComponents = ImageComponents.size() - preview.numKeptImageComponents;
+
+        state.style = getCurrentStyle();
+        state.appliedStyle = appliedStyle;
+        state.fontIsApplied = appliedFontIsValid;
+        state.colourIsApplied = appliedColourIsValid;
+        state.styleStack = styleStack;
+        state.lastChar = parser.lastChar;
+        state.orderedListCounter = OrderedListCounter;
+        state.lastListIsOrdered = lastListIsOrdered;
+        state.indentRange = lastIndentRange;
+        state.openLink = tmpHL;
+        return state;
+    }
+
+    void restoreBlockState(const BlockState& state)
+    {
+        charCounter = state.charCounter;
+        setCurrentStyle(state.style);
+        appliedStyle = state.appliedStyle;
+        appliedFontIsValid = state.fontIsApplied;
+        appliedColourIsValid = state.colourIsApplied;
+        styleStack = state.styleStack;
+        parser.lastChar = state.lastChar;
+        OrderedListCounter = state.orderedListCounter;
+        lastListIsOrdered = state.lastListIsOrdered;
+        lastIndentRange = state.indentRange;
+        tmpHL = state.openLink;
+        Comment = false;
+    }
+
+    // Returns true when the rest of the page can be kept from the previous version
+    bool recordBlockState(const char* position)
+    {
+        preview.states.add(captureBlockState(position));
+
+        if (preview.keptStart == nullptr || position < preview.keptStart)
+            return false;
+
+        if (position == preview.keptStart && preview.states.getLast().continuesLike(preview.previousStates.getReference(preview.keptState)))
+            return preview.keptPartReached = true;
+
+        dropKeptPart();
+        return false;
+    }
+
+    // The new version doesn't join the previous one where expected, the rest of the page is parsed instead
+    void dropKeptPart()
+    {
+        auto totalChars = textEditor->getTotalNumChars();
+        removeText({ totalChars - preview.keptTextLength, totalChars });
+        ImageComponents.removeLast(preview.numKeptImageComponents);
+
+        preview.keptStart = nullptr;
+        preview.keptTextLength = preview.numKeptImageComponents = 0;
+    }
+
+    // Add the kept part of the previous version to the document and the recorded states, moved to where
+    // it is now. Its text and images are already in place. Returns how far its text moved.
+    int joinKeptPart()
+    {
+        const auto& old = *preview.previousDocument;
+        const auto& from = preview.previousStates.getReference(preview.keptState);
+        const auto to = preview.states.getLast();
+        auto& doc = getDocumentForWriting();
+
+        auto textShift = to.textLength - from.textLength;
+        auto charShift = to.charCounter - from.charCounter;
+
+        for (int i = from.numOperations; i < old.operations.size(); i++)
+        {
+            auto op = old.operations[i];
+
+            switch (op.type)
+            {
+                case HtmlDocument::OperationType::text:
+                    doc.texts.add(old.texts[op.index]);
+                    op.index = doc.texts.size() - 1;
+                    op.position += textShift;
+                    break;
+
+                case HtmlDocument::OperationType::font:
+                    doc.fonts.add(old.fonts.getReference(op.index));
+                    doc.fontFaces.add(old.fontFaces[op.index]);
+                    op.index = doc.fonts.size() - 1;
+                    break;
+
+                case HtmlDocument::OperationType::colour:
+                    doc.colours.add(old.colours[op.index]);
+                    op.index = doc.colours.size() - 1;
+                    break;
+
+                case HtmlDocument::OperationType::image:
+                    doc.images.add(old.images.getReference(op.index));
+                    op.index = doc.images.size() - 1;
+                    break;
+
+                case HtmlDocument::OperationType::listSnapshot:
+                    doc.listRanges.add(old.listRanges[op.index] + textShift);
+                    op.index = doc.listRanges.size() - 1;
+                    break;
+            }
+
+            doc.operations.add(op);
+        }
+
+        for (int i = from.numLinks; i < old.links.size(); i++)
+        {
+            auto link = old.links[i];
+            link.position += charShift;
+            doc.links.add(link);
+        }
+
+        // Anchors of the kept part, the ones at the restart position stayed in the document
+        for (auto& anchor : old.anchors)
+            if (anchor.second >= from.charCounter && anchor.second > preview.restartCharCounter)
+                doc.anchors[anchor.first] = anchor.second + charShift;
+
+        // The images below the changed blocks move with the text
+        auto heightShift = getLaidOutTextHeight() - preview.previousTextHeight;
+        for (int i = ImageComponents.size() - preview.numKeptImageComponents; i < ImageComponents.size(); i++)
+            ImageComponents[i]->setTopLeftPosition(ImageComponents[i]->getPosition().translated(0, heightShift));
+
+        // The recorded states of the kept part and the end of the page (which is at the end of the HTML)
+        auto offsetShift = (int64)preview.source.getNumBytesAsUTF8() - (int64)preview.previousEndState.offset;
+        auto moveState = [&](BlockState state)
+        {
+            state.offset = (size_t)((int64)state.offset + offsetShift);
+            state.charCounter += charShift;
+            state.textLength += textShift;
+            state.numOperations += to.numOperations - from.numOperations;
+            state.numTexts += to.numTexts - from.numTexts;
+            state.numFonts += to.numFonts - from.numFonts;
+            state.numColours += to.numColours - from.numColours;
+            state.numImages += to.numImages - from.numImages;
+            state.numListRanges += to.numListRanges - from.numListRanges;
+            state.numLinks += to.numLinks - from.numLinks;
+            state.numImageComponents += to.numImageComponents - from.numImageComponents;
+            return state;
+        };
+
+        for (int i = preview.keptState + 1; i < preview.previousStates.size(); i++)
+            preview.states.add(moveState(preview.previousStates.getReference(i)));
+
+        preview.endState = moveState(preview.previousEndState);
+
+        // Continue after the page as if it had been parsed to the end
+        restoreBlockState(preview.endState);
+        textEditor->setFont(doc.fonts.getLast());
+        textEditor->setColour(TextEditor::ColourIds::textColourId, doc.colours.getLast());
+
+        preview.keptStart = nullptr;
+        preview.keptTextLength = preview.numKeptImageComponents = 0;
+        preview.keptPartReached = false;
+        return textShift;
+    }
+
+    // Remove what follows a recorded state from the document
+    void truncateDocument(const BlockState& state)
+    {
+        auto& doc = getDocumentForWriting();
+
+        doc.operations.removeRange(state.numOperations, doc.operations.size());
+        doc.texts.removeRange(state.numTexts, doc.texts.size());
+        doc.fonts.removeRange(state.numFonts, doc.fonts.size());
+        doc.fontFaces.removeRange(state.numFonts, doc.fontFaces.size());
+        doc.colours.removeRange(state.numColours, doc.colours.size());
+        doc.images.removeRange(state.numImages, doc.images.size());
+        doc.listRanges.removeRange(state.numListRanges, doc.listRanges.size());
+        doc.links.removeRange(state.numLinks, doc.links.size());
+
+        for (auto i = doc.anchors.begin(); i != doc.anchors.end();)
+        {
+            if (i->second > state.charCounter) i = doc.anchors.erase(i);
+            else ++i;
+        }
+    }
+
+    // Straight to the TextEditor, the document is updated separately
+    void removeText(Range<int> range)
+    {
+        if (range.isEmpty()) return;
+
+        textEditor->setHighlightedRegion(range);
+        textEditor->insertTextAtCaret({});
     }
 
     //==============================================================================
@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    HeadlessRenderer.h
+    Created: 19 Oct 2026
+
+    Renders HTML pages to PNG images from the command line, without opening
+    any window. Used to generate thumbnails of the help pages in batch:
+
+    HtmlTextEditor --render <files or folders...> [--out <folder>] [--width <pixels>] [--threads <count>]
+
+    Pages are laid out one at a time on the message thread, since that's
+    the only place where components can live, while PNG encoding and file
+    writing are spread across the shared thread pool, with at most --threads
+    pages being encoded at once.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "GSiHtmlTextEdit.h"
+#include "HtmlThreadPool.h"
+
+//==============================================================================
+class HeadlessRenderer
+{
+public:
+    HeadlessRenderer() = default;
+
+    static bool isBatchCommandLine(const String& commandLine)
+    {
+        return StringArray::fromTokens(commandLine, true).contains("--render");
+    }
+
+    // Render all the pages listed in the command line, returns the application's exit code
+    int run(const String& commandLine)
+    {
+        if (!parseArguments(commandLine))
+        {
+            print("Usage: --render <files or folders...> [--out <folder>] [--width <pixels>] [--threads <count>]");
+            return 1;
+        }
+
+        if (pages.isEmpty())
+        {
+            print("No HTML files found.");
+            return 1;
+        }
+
+        auto startTime = Time::getMillisecondCounterHiRes();
+        auto originalWorkingDirectory = File::getCurrentWorkingDirectory();
+
+        std::atomic<int> failures { 0 };
+        SharedResourcePointer<HtmlThreadPool> pool;
+        HtmlJobBatch encoders(*pool);
+
+        GSiHtmlTextEdit view;
+        view.setBackgroundColor(Colour(0xFF404050));
+        view.setMobileStyle(true); // The text editor covers the whole page, so that it can be captured at once
+        view.setSize(width, 600);
+
+        for (auto& page : pages)
+        {
+            // Don't let rendered pages pile up if the encoders can't keep up
+            encoders.waitUntilAtMost(numThreads - 1);
+
+            // Images with a relative path are searched in the working directory
+            page.source.getParentDirectory().setAsCurrentWorkingDirectory();
+
+            view.Reset(true);
+            auto snapshot = view.appendHtmlFromFile(page.source) ? view.getPageSnapshot() : Image();
+
+            if (!snapshot.isValid())
+            {
+                print("FAILED " + page.source.getFullPathName());
+                failures++;
+                continue;
+            }
+
+            encoders.add([this, snapshot, page, &failures]
+            {
+                page.destination.getParentDirectory().createDirectory();
+                page.destination.deleteFile();
+
+                FileOutputStream stream(page.destination);
+                if (stream.openedOk() && PNGImageFormat().writeImageToStream(snapshot, stream))
+                {
+                    print("OK " + page.destination.getFullPathName());
+                }
+                else
+                {
+                    print("FAILED " + page.destination.getFullPathName());
+                    failures++;
+                }
+            });
+        }
+
+        encoders.waitForAll();
+
+        originalWorkingDirectory.setAsCurrentWorkingDirectory();
+
+        print(String(pages.size() - failures.load()) + " of " + String(pages.size()) + " pages rendered in "
+              + String((Time::getMillisecondCounterHiRes() - startTime) / 1000.0, 2) + " s");
+
+        return failures > 0 ? 2 : 0;
+    }
+
+private:
+    struct Page
+    {
+        File source, destination;
+    };
+
+    Array<Page> pages;
+    int width = 800;
+    int numThreads = SystemStats::getNumCpus();
+    CriticalSection printLock;
+
+    bool parseArguments(const String& commandLine)
+    {
+        auto args = StringArray::fromTokens(commandLine, true);
+        auto outputFolder = File::getCurrentWorkingDirectory();
+        Array<File> inputs;
+
+        for (int i = 0; i < args.size(); i++)
+        {
+            auto arg = args[i].unquoted();
+
+            if (arg == "--render") continue;
+            else if (arg == "--out" && i + 1 < args.size()) outputFolder = File::getCurrentWorkingDirectory().getChildFile(args[++i].unquoted());
+            else if (arg == "--width" && i + 1 < args.size()) width = args[++i].unquoted().getIntValue();
+            else if (arg == "--threads" && i + 1 < args.size()) numThreads = args[++i].unquoted().getIntValue();
+            else if (arg.startsWith("--")) return false;
+            else inputs.add(File::getCurrentWorkingDirectory().getChildFile(arg));
+        }
+
+        if (inputs.isEmpty() || width <= 0 || numThreads <= 0)
+            return false;
+
+        for (auto& input : inputs)
+        {
+            if (input.isDirectory())
+            {
+                // Keep the folder structure, so that pages with the same name don't overwrite each other
+                for (auto& file : input.findChildFiles(File::findFiles, true, "*.htm;*.html"))
+                    pages.add({ file, outputFolder.getChildFile(file.getRelativePathFrom(input)).withFileExtension("png") });
+            }
+            else if (input.existsAsFile())
+            {
+                pages.add({ input, outputFolder.getChildFile(input.getFileNameWithoutExtension() + ".png") });
+            }
+            else
+            {
+                print("Not found: " + input.getFullPathName());
+            }
+        }
+
+        return true;
+    }
+
+    void print(const String& message)
+    {
+        const ScopedLock sl(printLock);
+        std::cout << message.toStdString() << std::endl;
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HeadlessRenderer)
+};
@@ -0,0 +1,240 @@
+/*
+  ==============================================================================
+
+    HtmlBenchmark.h
+    Created: 19 Oct 2026
+
+    Headless benchmark of GSiHtmlTextEdit, run from the command line:
+
+    HtmlTextEditor --benchmark [--iterations <count>] [--out <file.json>]
+                               [--scaling [--max-size <bytes>]]
+                               [--generate <file.htm> [--size <bytes>] [--seed <number>]]
+
+    Parsing, live preview updates, search, link hit-testing, page snapshots
+    and reset are timed on a few synthetic documents, each stressing a
+    different feature.
+    With --scaling, documents from 1 KB up to --max-size (4 MB by default)
+    are loaded to show how times grow with the document size, with and
+    without parallel parsing.
+    --generate just writes a synthetic document to disk and exits.
+    Results are printed as JSON (median and 99th percentile times, heap
+    allocations per run and per KB of input) so that they can be compared
+    between versions.
+    Allocations are only counted when the application is built with
+    GSI_COUNT_ALLOCATIONS=1, otherwise they read -1.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "GSiHtmlTextEdit.h"
+#include "HtmlCorpusGenerator.h"
+#include "AllocationCounter.h"
+
+//==============================================================================
+class HtmlBenchmark
+{
+public:
+    HtmlBenchmark() = default;
+
+    static bool isBenchmarkCommandLine(const String& commandLine)
+    {
+        return StringArray::fromTokens(commandLine, true).contains("--benchmark");
+    }
+
+    // Returns the application's exit code
+    int run(const String& commandLine)
+    {
+        auto args = StringArray::fromTokens(commandLine, true);
+        File outputFile, generateFile;
+        HtmlCorpusGenerator::Options generatorOptions;
+        bool scaling = false;
+        int64 maxSize = 4 * 1024 * 1024;
+
+        for (int i = 0; i < args.size(); i++)
+        {
+            auto arg = args[i].unquoted();
+            if (arg == "--iterations" && i + 1 < args.size()) iterations = jmax(1, args[++i].unquoted().getIntValue());
+            else if (arg == "--out" && i + 1 < args.size()) outputFile = File::getCurrentWorkingDirectory().getChildFile(args[++i].unquoted());
+            else if (arg == "--scaling") scaling = true;
+            else if (arg == "--max-size" && i + 1 < args.size()) maxSize = jmax((int64)1024, args[++i].unquoted().getLargeIntValue());
+            else if (arg == "--generate" && i + 1 < args.size()) generateFile = File::getCurrentWorkingDirectory().getChildFile(args[++i].unquoted());
+            else if (arg == "--size" && i + 1 < args.size()) generatorOptions.targetSize = args[++i].unquoted().getLargeIntValue();
+            else if (arg == "--seed" && i + 1 < args.size()) generatorOptions.seed = args[++i].unquoted().getLargeIntValue();
+        }
+
+        if (generateFile != File())
+            return generateFile.replaceWithText(HtmlCorpusGenerator::generate(generatorOptions)) ? 0 : 1;
+
+        GSiHtmlTextEdit view;
+        view.setSize(800, 600);
+
+        if (scaling)
+        {
+            runScaling(view, maxSize);
+        }
+        else
+        {
+            for (auto& corpus : createCorpora())
+                runCorpus(view, corpus);
+        }
+
+        DynamicObject::Ptr root = new DynamicObject();
+        root->setProperty("iterations", iterations);
+        root->setProperty("allocationsCounted", AllocationCounter::isEnabled());
+        root->setProperty("results", results);
+
+        auto json = JSON::toString(var(root.get()));
+        if (outputFile != File())
+            return outputFile.replaceWithText(json) ? 0 : 1;
+
+        std::cout << json.toStdString() << std::endl;
+        return 0;
+    }
+
+private:
+    struct Corpus
+    {
+        String name, html, searchFor;
+    };
+
+    int iterations = 20;
+    Array<var> results;
+
+    void runCorpus(GSiHtmlTextEdit& view, const Corpus& corpus)
+    {
+        auto load = [&] { view.Reset(true); view.appendHtml(corpus.html); };
+
+        measure(corpus, "appendHtml", [&] { view.Reset(true); }, [&] { view.appendHtml(corpus.html); });
+        measure(corpus, "Reset", load, [&] { view.Reset(true); });
+
+        // One character typed in the middle of the page, as in an editor with a live preview
+        auto edited = corpus.html.replaceSection(corpus.html.length() / 2, 0, "x");
+        measure(corpus, "updateHtml", [&] { view.Reset(true); view.updateHtml(corpus.html); }, [&] { view.updateHtml(edited); });
+
+        load();
+        measure(corpus, "searchAndHighlight", [&] { view.searchAndHighlight({}); }, [&] { view.searchAndHighlight(corpus.searchFor); });
+
+        // Hover a grid of points all over the visible area
+        measure(corpus, "linkHitTest", [] {}, [&]
+        {
+            for (int y = 0; y < view.getHeight(); y += 20)
+                for (int x = 0; x < view.getWidth(); x += 40)
+                    view.getLinkIndexAt({ x, y });
+        });
+
+        measure(corpus, "getPageSnapshot", [] {}, [&] { view.getPageSnapshot(); });
+    }
+
+    void measure(const Corpus& corpus, const String& operation, const std::function<void()>& prepare, const std::function<void()>& run)
+    {
+        Array<double> times;
+        int64 allocations = 0, bytes = 0;
+
+        for (int i = 0; i < iterations; i++)
+        {
+            prepare();
+
+            auto allocationsBefore = AllocationCounter::getNumAllocations();
+            auto bytesBefore = AllocationCounter::getNumBytes();
+            auto start = Time::getHighResolutionTicks();
+
+            run();
+
+            times.add(Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0);
+            allocations += AllocationCounter::getNumAllocations() - allocationsBefore;
+            bytes += AllocationCounter::getNumBytes() - bytesBefore;
+        }
+
+        times.sort();
+
+        DynamicObject::Ptr result = new DynamicObject();
+        result->setProperty("corpus", corpus.name);
+        result->setProperty("operation", operation);
+        result->setProperty("inputBytes", (int64)corpus.html.getNumBytesAsUTF8());
+        result->setProperty("medianMs", percentile(times, 0.5));
+        result->setProperty("p99Ms", percentile(times, 0.99));
+        result->setProperty("medianMsPerKB", percentile(times, 0.5) * 1024.0 / jmax(1.0, (double)corpus.html.getNumBytesAsUTF8()));
+        result->setProperty("allocations", AllocationCounter::isEnabled() ? var(allocations / iterations) : var(-1));
+        result->setProperty("allocatedBytes", AllocationCounter::isEnabled() ? var(bytes / iterations) : var(-1));
+        result->setProperty("allocationsPerKB", AllocationCounter::isEnabled() ? var((double)allocations / iterations * 1024.0 / jmax(1.0, (double)corpus.html.getNumBytesAsUTF8())) : var(-1));
+        results.add(var(result.get()));
+    }
+
+    static double percentile(const Array<double>& sortedValues, double p)
+    {
+        auto index = jlimit(0, sortedValues.size() - 1, (int)std::ceil(p * sortedValues.size()) - 1);
+        return sortedValues[index];
+    }
+
+    //==============================================================================
+    // Synthetic documents, each one stressing a different part of the parser
+
+    static Array<Corpus> createCorpora()
+    {
+        // Every corpus ends with the word that is searched for, so that the whole text is scanned
+        auto make = [](const String& name, HtmlCorpusGenerator::Options options)
+        {
+            options.targetSize = 256 * 1024;
+            return Corpus { name, HtmlCorpusGenerator::generate(options) + "<p>Sentinel</p>", "Sentinel" };
+        };
+
+        HtmlCorpusGenerator::Options manyTags, manyLinks, longPre, manyImages, plainText;
+
+        manyTags.tagDensity = 0.8f;
+        manyTags.maxNestingDepth = 6;
+        manyTags.entityDensity = 0.2f;
+
+        manyLinks.linksPerKB = 20.0f;
+
+        longPre.preProportion = 1.0f;
+
+        manyImages.imagesPerKB = 1.0f;
+
+        plainText.tagDensity = plainText.linksPerKB = plainText.imagesPerKB = plainText.entityDensity = plainText.preProportion = 0.0f;
+
+        Array<Corpus> corpora;
+        corpora.add(make("manyTags", manyTags));
+        corpora.add(make("manyLinks", manyLinks));
+        corpora.add(make("longPre", longPre));
+        corpora.add(make("manyImages", manyImages));
+        corpora.add(make("plainText", plainText));
+        return corpora;
+    }
+
+    // Load documents of growing size (x4 each step) to see where the time stops growing linearly
+    void runScaling(GSiHtmlTextEdit& view, int64 maxSize)
+    {
+        for (int64 size = 1024; size <= maxSize; size = (size * 4 > maxSize && size < maxSize) ? maxSize : size * 4)
+        {
+            HtmlCorpusGenerator::Options options;
+            options.targetSize = size;
+
+            Corpus corpus { "scaling", HtmlCorpusGenerator::generate(options), "Sentinel" };
+
+            // Big documents take long enough to be measured with fewer runs
+            auto savedIterations = iterations;
+            iterations = (int)jlimit<int64>(1, iterations, (4 * 1024 * 1024) / size);
+
+            measure(corpus, "appendHtml", [&] { view.Reset(true); }, [&] { view.appendHtml(corpus.html); });
+
+            view.setParallelParsing(1);
+            measure(corpus, "appendHtml parallel", [&] { view.Reset(true); }, [&] { view.appendHtml(corpus.html); });
+            view.setParallelParsing(0);
+
+            measure(corpus, "linkHitTest", [] {}, [&]
+            {
+                for (int y = 0; y < view.getHeight(); y += 20)
+                    for (int x = 0; x < view.getWidth(); x += 40)
+                        view.getLinkIndexAt({ x, y });
+            });
+
+            iterations = savedIterations;
+        }
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HtmlBenchmark)
+};
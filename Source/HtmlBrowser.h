@@ -18,6 +18,9 @@
 
 #include <JuceHeader.h>
 #include "GSiHtmlTextEdit.h"
+#include "PageTileExporter.h"
+#include "HtmlDebugOverlay.h"
+#include "HtmlSearchIndex.h"
 #include "Common_UI.h"
 
 //==============================================================================
@@ -36,23 +39,40 @@ public:
         //htmlView->setShowAnchorPopup(false);
         //htmlView->setMobileStyle(true);
         //htmlView->useImageIdents = true;
+
+        // Let the other browsers in the process show the pages parsed here
+        htmlView->onParsingComplete = [this]
+        {
+            if (pageToShare.isNotEmpty())
+                documentCache->add(pageToShare, htmlView->getDocument());
+
+            pageToShare.clear();
+        };
         
 
 
         btnLoad.reset(new SquareButton("Load HTML", 1));
         btnLoad->onClickCallback = [&](const MouseEvent&) 
         {
-            fileChooser.reset(new FileChooser("Load HTML file", File::getCurrentWorkingDirectory(), "*.htm;*.html", true));
+            fileChooser.reset(new FileChooser("Load HTML file or help bundle", File::getCurrentWorkingDirectory(), "*.htm;*.html;*.zip", true));
             fileChooser->launchAsync(FileBrowserComponent::openMode | FileBrowserComponent::canSelectFiles,
                 [&](const FileChooser& fc) mutable
                 {
-                    if (fc.getURLResults().size() > 0)
+                    if (fc.getURLResults().size() > 0 && fc.getResult().hasFileExtension("zip"))
                     {
+                        OpenHelpBundle(fc.getResult());
+                    }
+                    else if (fc.getURLResults().size() > 0)
+                    {
+                        cancelExport();
                         history.clear();
-                        auto HTML = fc.getResult().loadFileAsString();
+                        pageToShare.clear();
+                        lastPageRequest++; // Don't let a page still being fetched replace this one
+                        currentPageName.clear();
 
+                        // Files opened before are shown from the disk cache, without parsing them again
                         htmlView->Reset(true);
-                        htmlView->appendHtml(HTML);
+                        htmlView->loadHtmlFileWithCache(fc.getResult(), diskCache);
                         htmlView->getPointerToTextEditorComponent()->moveCaretToTop(false);
                     }
                 });
@@ -68,6 +88,10 @@ public:
         btnSearch->onClickCallback = [&](const MouseEvent&) { DoSearch(); };
         addAndMakeVisible(btnSearch.get());
 
+        btnSearchAll.reset(new SquareButton("Search all", 1));
+        btnSearchAll->onClickCallback = [&](const MouseEvent&) { DoSearchAllPages(); };
+        addAndMakeVisible(btnSearchAll.get());
+
         searchField.reset(new Label("searchField", "Search..."));
         searchField->setEditable(true, false, false);
         //searchField->onTextChange = [&] { DoSearch(); };
@@ -76,11 +100,23 @@ public:
         btnExport.reset(new SquareButton("EXPORT", 1));
         btnExport->onClickCallback = [&](const MouseEvent&)
         {
+            // Clicking while a tiled export is running cancels it
+            if (exporter != nullptr && exporter->isRunning())
+            {
+                cancelExport();
+                return;
+            }
+
             fileChooser.reset(new FileChooser(translate("Save to..."), File::getSpecialLocation(File::userDesktopDirectory).getFullPathName(), "*.png", true));
             fileChooser->launchAsync(FileBrowserComponent::saveMode | FileBrowserComponent::canSelectFiles | FileBrowserComponent::warnAboutOverwriting,
                 [this](const FileChooser& fc) mutable
                 {
-                    if (fc.getURLResults().size() > 0)
+                    if (fc.getURLResults().size() == 0) return;
+
+                    // Very tall pages are saved as a set of tiles, compressed in the background
+                    if (htmlView->getPageArea().getHeight() > maxSingleImageHeight && fc.getURLResult().isLocalFile())
+                        ExportTiles(fc.getResult());
+                    else
                         htmlView->exportPageToImage(fc.getURLResult());
                 }
             );
@@ -102,6 +138,22 @@ public:
                 LoadPage(s);
         };
 
+#if JUCE_WINDOWS && _DEBUG
+        // Load the pages from the source folder in DEBUG mode, so that they can be edited without rebuilding
+        auto sourceFolder = File::getCurrentWorkingDirectory().getChildFile("../../Source/Resources");
+        if (!resources->locate("page1.htm").startsWith(sourceFolder.getFullPathName()))
+        {
+            auto chain = new ChainedResourceProvider();
+            chain->add(new DirectoryResourceProvider(sourceFolder));
+            chain->add(resources->getProvider());
+            resources->setProvider(chain);
+        }
+#endif
+        baseProvider = resources->getProvider();
+
+        debugOverlay.reset(new HtmlDebugOverlay(*htmlView));
+        addChildComponent(debugOverlay.get());
+
         addKeyListener(this);
         setWantsKeyboardFocus(true);
     }
@@ -109,13 +161,46 @@ public:
     void Show()
     {
         history.clear();
-        LoadPage("page1.htm");
+        LoadPage(startPage);
         Desktop::getInstance().getAnimator().fadeIn(this, 250);
     }
 
+    // Show the pages of a zip file that contains a whole help set, with its images and fonts.
+    // Only the pages that are viewed get decompressed.
+    bool OpenHelpBundle(const File& zipFile)
+    {
+        ReferenceCountedObjectPtr<ZipResourceProvider> bundle = new ZipResourceProvider(zipFile);
+        auto bundleStartPage = bundle->getStartPage();
+
+        if (bundleStartPage.isEmpty())
+        {
+            dialog->Open(GSiDialogWindow::AlertType::typeError, "Help bundle", "No pages found in " + zipFile.getFileName());
+            return false;
+        }
+
+        // What isn't in the bundle is searched where it was before, e.g. the embedded fonts
+        auto chain = new ChainedResourceProvider();
+        chain->add(bundle.get());
+        chain->add(baseProvider);
+        resources->setProvider(chain);
+        helpBundle = bundle;
+
+        // Search all must list the pages of the bundle now, not the embedded ones
+        searchIndexReady = false;
+
+        startPage = bundleStartPage;
+        currentPageName.clear();
+        history.clear();
+        LoadPage(startPage);
+        return true;
+    }
+
     void Hide()
     {
         Desktop::getInstance().getAnimator().fadeOut(this, 250);
+
+        // The page is loaded again by Show(), no need to keep it in memory meanwhile
+        htmlView->trimMemory(GSiHtmlTextEdit::trimEverything);
     }
 
     void Back()
@@ -125,25 +210,101 @@ public:
         LoadPage(history.getLast(), true);
     }
 
-    void LoadPage(const String& page, bool goingBack = false)
+    // The page is fetched with its images on a background thread, then shown. If there's some
+    // text to highlight, the page scrolls to its first occurrence. A page like "page.htm#section"
+    // scrolls to that anchor, and just "#section" scrolls the page being shown.
+    void LoadPage(const String& page, bool goingBack = false, const String& textToHighlight = {})
     {
-        if (!goingBack) history.add(page);
+        auto file = page.upToFirstOccurrenceOf("#", false, false);
+        auto anchor = page.fromFirstOccurrenceOf("#", false, false);
+
+        // Going back to this anchor must show this page
+        if (!goingBack) history.add(file.isEmpty() && currentPageName.isNotEmpty() ? currentPageName + page : page);
         btnBack->setEnabled(history.size() > 1);
 
-#if JUCE_WINDOWS && _DEBUG
-        // Load HTML from file in DEBUG mode
-        String HTML = File::getCurrentWorkingDirectory().getChildFile("../../Source/Resources/" + page).loadFileAsString();
-#else
-        // Get the file from the resources
-        String resource = page.replace(".", "_");
-        int FileSize = 0;
-        String HTML = String(BinaryData::getNamedResource(resource.toRawUTF8(), FileSize));
-#endif
-        if (HTML.isEmpty()) return;
+        // Anchors in the page being shown are reached without loading it again
+        if (file.isEmpty() || (file == currentPageName && anchor.isNotEmpty()))
+        {
+            htmlView->scrollToAnchor(anchor);
+            return;
+        }
+
+        cancelExport();
+
+        auto request = ++lastPageRequest;
+        Component::SafePointer<SimpleHtmlBrowser> safeThis(this);
+
+        resources->fetchPageAsync(file, [safeThis, request, file, textToHighlight, anchor](HtmlResource::Ptr resource)
+        {
+            // Only show the last page asked for
+            if (safeThis != nullptr && request == safeThis->lastPageRequest)
+            {
+                safeThis->ShowPage(resource, textToHighlight);
+                safeThis->currentPageName = resource != nullptr ? file : String();
+
+                if (anchor.isNotEmpty())
+                    safeThis->htmlView->scrollToAnchor(anchor);
+            }
+        });
+    }
+
+    void ShowPage(HtmlResource::Ptr resource, const String& textToHighlight = {})
+    {
+        pageToShare.clear();
+        if (resource == nullptr) return;
 
         htmlView->Reset(true);
-        htmlView->appendHtml(HTML);
+        currentPage = resource; // The parser reads the page in place, it must stay in memory
+
+        // If another browser already has this page, show it without parsing it again
+        if (auto document = documentCache->find(resource->location))
+        {
+            htmlView->setDocument(document);
+        }
+        else
+        {
+            pageToShare = resource->location;
+            htmlView->appendHtmlProgressively(resource->getData(), resource->getSize(), resource->hasPermanentData());
+        }
+
         htmlView->getPointerToTextEditorComponent()->moveCaretToTop(false);
+
+        if (textToHighlight.isNotEmpty())
+        {
+            searchField->setText(textToHighlight, dontSendNotification);
+            htmlView->searchAndHighlight(textToHighlight);
+        }
+    }
+
+    void ExportTiles(const File& chosenFile)
+    {
+        auto folder = chosenFile.getSiblingFile(chosenFile.getFileNameWithoutExtension() + "_tiles");
+
+        exporter.reset(new PageTileExporter(*htmlView, folder));
+        exporter->onProgress = [this](double progress)
+        {
+            btnExport->setLabels("CANCEL " + String(roundToInt(progress * 100.0)) + "%");
+        };
+        exporter->onFinished = [this, folder](bool success)
+        {
+            btnExport->setLabels("EXPORT");
+            if (success)
+                dialog->Open(GSiDialogWindow::AlertType::typeInfoAutoClose, "Export", "Page exported to " + folder.getFileName());
+            else
+                dialog->Open(GSiDialogWindow::AlertType::typeError, "Export", "Could not export the page.");
+        };
+
+        if (!exporter->start())
+            exporter->onFinished(false);
+    }
+
+    // All the tiles must come from the same page, so showing another one cancels the export
+    void cancelExport()
+    {
+        if (exporter == nullptr || !exporter->isRunning()) return;
+
+        exporter->cancel();
+        btnExport->setLabels("EXPORT");
     }
 
     void DoSearch()
@@ -153,15 +314,164 @@ public:
         htmlView->searchAndHighlight(text);
     }
 
+    // Search all the pages in the resources, the results are shown in a menu
+    void DoSearchAllPages()
+    {
+        auto text = searchField->getText();
+
+        // The first search waits for the index, the last one asked for is done once it's ready
+        if (!searchIndexReady)
+        {
+            pendingSearch = text;
+            prepareSearchIndex();
+            return;
+        }
+
+        showSearchResults(text);
+    }
+
+    void showSearchResults(const String& text)
+    {
+        auto startTime = Time::getMillisecondCounterHiRes();
+        auto results = searchIndex->search(text);
+        DBG("Search all for: " << text << ", " << results.size() << " results in " << String(Time::getMillisecondCounterHiRes() - startTime, 2) << " ms");
+
+        if (results.isEmpty())
+        {
+            dialog->Open(GSiDialogWindow::AlertType::typeInfoAutoClose, "Search", "Nothing found for " + text.quoted());
+            return;
+        }
+
+        PopupMenu menu;
+        for (int i = 0; i < results.size(); i++)
+            menu.addItem(i + 1, results.getReference(i).title + "  -  " + results.getReference(i).snippet);
+
+        menu.showMenuAsync(PopupMenu::Options().withTargetComponent(btnSearchAll.get()), [this, results](int chosen)
+        {
+            if (chosen <= 0) return;
+
+            auto& result = results.getReference(chosen - 1);
+            LoadPage(result.page, false, result.highlight);
+        });
+    }
+
 private:
     std::unique_ptr<GSiHtmlTextEdit> htmlView;
-    std::unique_ptr<SquareButton> btnLoad, btnBack, btnSearch, btnExport;
+    std::unique_ptr<SquareButton> btnLoad, btnBack, btnSearch, btnSearchAll, btnExport;
     std::unique_ptr<GSiDialogWindow> dialog;
     std::unique_ptr<Label> searchField;
 
     Array<String> history;
+    SharedResourcePointer<HtmlDocumentCache> documentCache;
+    String pageToShare;
+
+    SharedResourcePointer<HtmlResources> resources;
+    HtmlResourceProvider::Ptr baseProvider; // Where resources come from when no help bundle is open
+    ReferenceCountedObjectPtr<ZipResourceProvider> helpBundle;
+    HtmlResource::Ptr currentPage;
+    String currentPageName;
+    String startPage = "page1.htm";
+    int lastPageRequest = 0;
+
+    SharedResourcePointer<HtmlSearchIndex> searchIndex;
+    ThreadPool searchIndexThread { 1 };
+    bool preparingSearchIndex = false;
+    bool searchIndexReady = false;      // The index holds the pages of the help bundle open, or the embedded ones
+    String pendingSearch;
+    HtmlDocumentDiskCache diskCache { File::getSpecialLocation(File::tempDirectory).getChildFile("HtmlTextEditor_documents") };
 
     std::unique_ptr<FileChooser> fileChooser;
+    std::unique_ptr<PageTileExporter> exporter;
+    std::unique_ptr<HtmlDebugOverlay> debugOverlay;
+
+    // Pages taller than this are exported as tiles
+    static constexpr int maxSingleImageHeight = 8192;
+
+    // The index of all the pages is built on a background thread at the first search, or loaded if a
+    // previous run saved it. The search asked for meanwhile is done once it's ready.
+    // Opening a help bundle meanwhile starts it again with the pages of the bundle.
+    void prepareSearchIndex()
+    {
+        if (preparingSearchIndex) return;
+        preparingSearchIndex = true;
+
+        Component::SafePointer<SimpleHtmlBrowser> safeThis(this);
+        auto bundle = helpBundle;
+
+        searchIndexThread.addJob([safeThis, bundle]
+        {
+            SharedResourcePointer<HtmlSearchIndex> index;
+            loadOrBuildSearchIndex(*index, bundle.get());
+
+            MessageManager::callAsync([safeThis, bundle]
+            {
+                if (safeThis == nullptr) return;
+
+                safeThis->preparingSearchIndex = false;
+                if (safeThis->helpBundle != bundle)
+                {
+                    safeThis->prepareSearchIndex();
+                    return;
+                }
+
+                safeThis->searchIndexReady = true;
+                safeThis->showSearchResults(safeThis->pendingSearch);
+                safeThis->pendingSearch.clear();
+            });
+        });
+    }
+
+    // Indexes the pages of the bundle, or the embedded ones if it's null
+    static void loadOrBuildSearchIndex(HtmlSearchIndex& index, ZipResourceProvider* bundle)
+    {
+        Array<HtmlSearchIndex::Source> sources;
+        ReferenceCountedArray<HtmlResource> bundlePages;   // Keeps the decompressed pages until they're indexed
+        auto indexFile = File::getSpecialLocation(File::tempDirectory).getChildFile("HtmlTextEditor_search.idx");
+
+        if (bundle != nullptr)
+        {
+            for (auto& page : bundle->getEntryNames())
+            {
+                if (!page.endsWithIgnoreCase(".htm") && !page.endsWithIgnoreCase(".html")) continue;
+
+                if (auto resource = bundle->fetch(page))
+                {
+                    bundlePages.add(resource);
+                    sources.add({ page, resource->getData(), resource->getSize() });
+                }
+            }
+
+            // Each bundle keeps its own index, so switching between them doesn't build them again
+            auto bundleId = String::toHexString(bundle->getZipFile().getFullPathName().hashCode64());
+            indexFile = indexFile.getSiblingFile("HtmlTextEditor_search_" + bundleId + ".idx");
+        }
+        else for (int i = 0; i < BinaryData::namedResourceListSize; i++)
+        {
+            String page = BinaryData::getNamedResourceOriginalFilename(BinaryData::namedResourceList[i]);
+            if (page.endsWithIgnoreCase(".gz")) page = page.dropLastCharacters(3);
+            if (!page.endsWithIgnoreCase(".htm") && !page.endsWithIgnoreCase(".html")) continue;
+
+            int size = 0;
+            auto data = CompressedBinaryData::getNamedResource(BinaryDataResourceProvider::getResourceName(page).toRawUTF8(), size);
+            sources.add({ page, data, (size_t)size });
+        }
+
+        auto signature = HtmlSearchIndex::getSignature(sources);
+        if (index.getPagesSignature() == signature) return;
+
+        {
+            FileInputStream in(indexFile);
+            if (in.openedOk() && index.readFrom(in, signature))
+                return;
+        }
+
+        index.build(sources);
+
+        indexFile.deleteFile();
+        FileOutputStream out(indexFile);
+        if (out.openedOk())
+            index.writeTo(out);
+    }
 
     void paint(juce::Graphics& g) override
     {
@@ -172,15 +482,43 @@ private:
     {
         btnLoad->setBounds(0, 0, 100, 30);
         btnBack->setBounds(110, 0, 100, 30);
-        searchField->setBounds(220, 0, getWidth() - 220 - 230, 30);
+        searchField->setBounds(220, 0, getWidth() - 220 - 340, 30);
+        btnSearchAll->setBounds(getWidth() - 330, 0, 100, 30);
         btnSearch->setBounds(getWidth() - 220, 0, 100, 30);
         btnExport->setBounds(getWidth() - 110, 0, 100, 30);
 
         htmlView->setBounds(0, 35, getWidth(), getHeight() - 40);
+        debugOverlay->setBounds(getWidth() - 380, 45, 360, 130);
     }
 
     bool keyPressed(const KeyPress& key, Component* originatingComponent) override
     {
+        // F12 shows or hides the debug overlay
+        if (key == KeyPress::F12Key)
+        {
+            debugOverlay->setVisible(!debugOverlay->isVisible());
+            debugOverlay->toFront(false);
+        }
+
+        // F9 starts recording a trace, pressing it again saves it on the desktop
+        if (key == KeyPress::F9Key)
+        {
+            if (!TraceRecorder::isRecording())
+            {
+                TraceRecorder::start();
+                dialog->Open(GSiDialogWindow::AlertType::typeInfoAutoClose, "Trace", "Recording, press F9 again to stop.");
+            }
+            else
+            {
+                TraceRecorder::stop();
+                auto file = File::getSpecialLocation(File::userDesktopDirectory).getNonexistentChildFile("HtmlTextEditor_trace", ".json");
+                if (TraceRecorder::writeToFile(file))
+                    dialog->Open(GSiDialogWindow::AlertType::typeInfoAutoClose, "Trace", "Saved to " + file.getFileName());
+                else
+                    dialog->Open(GSiDialogWindow::AlertType::typeError, "Trace", "Could not save the trace.");
+            }
+        }
+
 #if (_DEBUG && JUCE_WINDOWS)
         if (key == key.F5Key)
         {
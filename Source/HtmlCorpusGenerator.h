@@ -0,0 +1,219 @@
+/*
+  ==============================================================================
+
+    HtmlCorpusGenerator.h
+    Created: 19 Oct 2026
+
+    Generates synthetic HTML documents for benchmarks and scaling tests.
+    The output only depends on the options (including the seed), so the
+    same options always give the same document. Every tag supported by
+    GSiHtmlTextEdit can appear, in proportions set by the options.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class HtmlCorpusGenerator
+{
+public:
+    struct Options
+    {
+        int64 targetSize = 64 * 1024;   // Approximate size of the document in bytes
+        float tagDensity = 0.2f;        // Probability of each word to open an inline element (b, i, font, span...)
+        int maxNestingDepth = 3;        // Maximum number of nested inline elements
+        float linksPerKB = 1.0f;        // Anchors per KB of output
+        float imagesPerKB = 0.05f;      // Images per KB of output
+        float entityDensity = 0.02f;    // Probability of each word to be followed by an HTML entity
+        float preProportion = 0.1f;     // Probability of each block to be a <pre> block
+        int64 seed = 1;
+    };
+
+    static String generate(const Options& options)
+    {
+        HtmlCorpusGenerator generator(options);
+        return generator.build();
+    }
+
+private:
+    HtmlCorpusGenerator(const Options& o) : options(o), random(o.seed) {}
+
+    const Options& options;
+    Random random;
+    MemoryOutputStream out;
+    StringArray openElements;
+    int64 lastLinkPosition = 0, lastImagePosition = 0;
+    int blockCounter = 0;
+
+    String build()
+    {
+        out.preallocate((size_t)options.targetSize + 4096);
+
+        while ((int64)out.getDataSize() < options.targetSize)
+        {
+            if (random.nextFloat() < options.preProportion) writePre();
+            else
+            {
+                switch (random.nextInt(8))
+                {
+                case 0:  writeHeader(); break;
+                case 1:  writeList(); break;
+                case 2:  writeStyledParagraph(); break;
+                case 3:  writeComment(); break;
+                default: writeParagraph(); break;
+                }
+            }
+
+            blockCounter++;
+        }
+
+        return out.toUTF8();
+    }
+
+    //==============================================================================
+    void writeParagraph()
+    {
+        out << "<p>";
+        writeText(20 + random.nextInt(60));
+        out << "</p>\n";
+    }
+
+    void writeStyledParagraph()
+    {
+        static const char* styles[] = {
+            "color: #CC0000", "font-weight: bold", "font-size: 20px", "text-decoration: underline",
+            "font-family: 'Times New Roman'; color: #2060FF"
+        };
+
+        auto style = styles[random.nextInt(numElementsInArray(styles))];
+        bool useSpan = random.nextBool();
+
+        out << (useSpan ? "<span style=\"" : "<p style=\"") << style << "\">";
+        writeText(10 + random.nextInt(40));
+        out << (useSpan ? "</span><br>\n" : "</p>\n");
+    }
+
+    void writeHeader()
+    {
+        auto level = 1 + random.nextInt(4);
+        out << "<h" << level << ">Section " << blockCounter << "</h" << level << ">\n";
+    }
+
+    void writeList()
+    {
+        auto ordered = random.nextBool();
+        out << (ordered ? "<ol>\n" : "<ul>\n");
+
+        for (int i = 1 + random.nextInt(8); --i >= 0;)
+        {
+            out << "<li>";
+            writeText(3 + random.nextInt(20));
+            out << "</li>\n";
+        }
+
+        out << (ordered ? "</ol>\n" : "</ul>\n");
+    }
+
+    void writePre()
+    {
+        out << (random.nextBool() ? "<pre>\n" : "<pre style=\"color: #A0FFA0\">\n");
+
+        for (int i = 2 + random.nextInt(20); --i >= 0;)
+        {
+            out << "\tint value" << blockCounter << "_" << i << " = doSum(a, b); // <b>not a tag</b> &amp; no entity\n";
+        }
+
+        out << "</pre>\n";
+    }
+
+    void writeComment()
+    {
+        out << "<!-- Comment " << blockCounter << " with <b>markup</b> that must not be rendered -->\n";
+    }
+
+    //==============================================================================
+    void writeText(int numWords)
+    {
+        static const char* words[] = {
+            "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "sound", "synthesizer",
+            "organ", "oscillator", "filter", "envelope", "preset", "manual", "chapter", "parameter",
+            "value", "control", "window", "browser", "plugin", "keyboard", "velocity", "music"
+        };
+
+        for (int i = 0; i < numWords; i++)
+        {
+            if (random.nextFloat() < options.tagDensity && openElements.size() < options.maxNestingDepth)
+                openInlineElement();
+
+            auto position = (int64)out.getDataSize();
+
+            if (options.linksPerKB > 0.0f && position - lastLinkPosition >= (int64)(1024.0f / options.linksPerKB))
+            {
+                lastLinkPosition = position;
+                if (random.nextInt(4) == 0) out << "<a href=\"page" << random.nextInt(100) << ".htm\">";
+                else out << "<a href=\"https://www.example.com/" << blockCounter << "\">";
+                out << words[random.nextInt(numElementsInArray(words))] << "</a> ";
+            }
+
+            if (options.imagesPerKB > 0.0f && position - lastImagePosition >= (int64)(1024.0f / options.imagesPerKB))
+            {
+                lastImagePosition = position;
+                out << "<br><img src=\"logo_GSi_680x219.png\"" << (random.nextBool() ? " width=\"200\"" : "") << "/>";
+            }
+
+            out << words[random.nextInt(numElementsInArray(words))];
+
+            if (random.nextFloat() < options.entityDensity)
+            {
+                static const char* entities[] = { "&nbsp;", "&amp;", "&quot;", "&lt;", "&laquo;", "&raquo;", "&#39;", "&#8364;" };
+                out << entities[random.nextInt(numElementsInArray(entities))];
+            }
+
+            out << (random.nextInt(12) == 0 ? "\n" : " ");
+
+            if (openElements.size() > 0 && random.nextInt(4) == 0)
+                closeInlineElement();
+        }
+
+        while (openElements.size() > 0)
+            closeInlineElement();
+    }
+
+    void openInlineElement()
+    {
+        static const char* elements[] = { "b", "strong", "i", "em", "u", "font", "small", "big", "span" };
+        String name = elements[random.nextInt(numElementsInArray(elements))];
+
+        if (name == "font")
+        {
+            switch (random.nextInt(3))
+            {
+            case 0:  out << "<font color=\"#20FF20\">"; break;
+            case 1:  out << "<font size=\"24\">"; break;
+            default: out << "<font face=\"Times New Roman\" color=\"#FFC020\">"; break;
+            }
+        }
+        else if (name == "span")
+        {
+            out << "<span style=\"font-weight: bold; color: #CC0000\">";
+        }
+        else
+        {
+            out << "<" << name << ">";
+        }
+
+        openElements.add(name);
+    }
+
+    void closeInlineElement()
+    {
+        out << "</" << openElements[openElements.size() - 1] << ">";
+        openElements.remove(openElements.size() - 1);
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HtmlCorpusGenerator)
+};
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    HtmlDebugOverlay.h
+    Created: 19 Oct 2026
+
+    A small box drawn over a GSiHtmlTextEdit that shows what it is doing:
+    how long the view's last repaint took, timings of the last page load,
+    images, cached typefaces and document size. Meant for spotting performance problems
+    in release builds, without attaching a profiler.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "GSiHtmlTextEdit.h"
+
+//==============================================================================
+class HtmlDebugOverlay : public juce::Component, private juce::Timer
+{
+public:
+    HtmlDebugOverlay(GSiHtmlTextEdit& viewToWatch) : view(viewToWatch)
+    {
+        setInterceptsMouseClicks(false, false);
+    }
+
+    void visibilityChanged() override
+    {
+        if (isVisible()) startTimer(250);
+        else stopTimer();
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        g.setColour(Colour(0xC0000000));
+        g.fillRoundedRectangle(getLocalBounds().toFloat(), 5.f);
+
+        g.setColour(Colours::lightgreen);
+        g.setFont(Font(Font::getDefaultMonospacedFontName(), 13.f, Font::FontStyleFlags::plain));
+        g.drawMultiLineText(text, 8, 18, getWidth() - 16);
+    }
+
+private:
+    GSiHtmlTextEdit& view;
+    String text;
+
+    void timerCallback() override
+    {
+        const auto& stats = view.getRenderStats();
+        auto memory = view.getMemoryUsage();
+
+        text = "Last paint:   " + String(view.getLastPaintMs(), 2) + " ms\n"
+             + "Last load:    " + String(stats.totalMs, 1) + " ms" + (view.isParsing() ? " (loading...)" : "") + "\n"
+             + "  layout:     " + String(stats.layoutMs, 1) + " ms\n"
+             + "  images:     " + String(stats.imageDecodeMs, 1) + " ms\n"
+             + "Images:       " + String(view.getNumImageComponents()) + " (" + File::descriptionOfSizeInBytes(view.getDecodedImageBytes()) + ")\n"
+             + "Typefaces:    " + String(GSiHtmlTextEdit::getNumCachedTypefaces()) + " cached (" + File::descriptionOfSizeInBytes(memory.typefaces) + ")\n"
+             + "Text:         " + String(view.getDocumentLength()) + " chars, " + String(view.getNumLinks()) + " links\n"
+             + "Memory:       " + File::descriptionOfSizeInBytes(memory.getTotal());
+
+        repaint();
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HtmlDebugOverlay)
+};
@@ -0,0 +1,460 @@
+/*
+  ==============================================================================
+
+    HtmlDocument.h
+    Created: 19 Oct 2026
+
+    A parsed HTML page: the text runs, fonts, colours, images and links that
+    GSiHtmlTextEdit produced while parsing, stored as the list of steps that
+    build the page in a TextEditor. A document is reference-counted and never
+    modified once it's shared, so the same page can be shown in any number of
+    views (e.g. one per plugin instance) while being parsed only once, and its
+    images decoded only once. Each view keeps its own layout and scroll state.
+
+    Get one with GSiHtmlTextEdit::getDocument(), show it with setDocument().
+    HtmlDocumentCache keeps documents by name, for all the views in the process.
+    HtmlDocumentDiskCache saves them in files, so that an HTML file that hasn't
+    changed isn't parsed again the next time the program runs.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <unordered_map>
+
+//==============================================================================
+class HtmlDocument : public ReferenceCountedObject
+{
+public:
+    using Ptr = ReferenceCountedObjectPtr<HtmlDocument>;
+
+    HtmlDocument() = default;
+
+    struct Link
+    {
+        String url;
+        Range<int> position;
+    };
+
+    const Array<Link>& getLinks() const noexcept    { return links; }
+
+    // Where a named anchor (<a name="..."> or the id of an element) is in the text, or -1
+    int getAnchorPosition(const String& name) const
+    {
+        auto i = anchors.find(name);
+        return i != anchors.end() ? i->second : -1;
+    }
+
+    int getNumOperations() const noexcept           { return operations.size(); }
+
+    // Number of characters the page takes in a TextEditor
+    int getLength() const noexcept                  { return length; }
+
+    // Approximate memory taken by the document, not counting the decoded images
+    int64 getMemorySize() const
+    {
+        auto bytes = (int64)sizeof(HtmlDocument)
+                   + (int64)operations.size() * (int64)sizeof(Operation)
+                   + (int64)fonts.size() * (int64)sizeof(Font)
+                   + (int64)colours.size() * (int64)sizeof(Colour)
+                   + (int64)images.size() * (int64)sizeof(EmbeddedImage)
+                   + (int64)listRanges.size() * (int64)sizeof(Range<int>);
+
+        for (auto& t : texts)
+            bytes += (int64)sizeof(String) + (int64)t.getNumBytesAsUTF8();
+
+        for (auto& l : links)
+            bytes += (int64)sizeof(Link) + (int64)l.url.getNumBytesAsUTF8();
+
+        for (auto& f : fontFaces)
+            bytes += (int64)sizeof(String) + (int64)f.getNumBytesAsUTF8();
+
+        for (auto& a : anchors)
+            bytes += (int64)sizeof(a) + (int64)a.first.getNumBytesAsUTF8();
+
+        return bytes;
+    }
+
+    //==============================================================================
+    // Saving and loading. Images aren't saved, only where they come from: they are loaded
+    // again when the document is shown.
+
+    // Increase it once in each release that changes the parser or the saved format, so that the
+    // documents saved by a previous release are parsed again
+    static constexpr int formatVersion = 1;
+
+    void writeTo(OutputStream& out) const
+    {
+        out.writeCompressedInt(operations.size());
+        for (auto& op : operations)
+        {
+            out.writeByte((char)op.type);
+            out.writeCompressedInt(op.index);
+            out.writeCompressedInt(op.position);
+        }
+
+        out.writeCompressedInt(texts.size());
+        for (auto& t : texts)
+            out.writeString(t);
+
+        out.writeCompressedInt(fonts.size());
+        for (int i = 0; i < fonts.size(); i++)
+        {
+            out.writeString(fontFaces[i]);
+            out.writeFloat(fonts.getReference(i).getHeight());
+            out.writeCompressedInt(fonts.getReference(i).getStyleFlags());
+        }
+
+        out.writeCompressedInt(colours.size());
+        for (auto& c : colours)
+            out.writeInt((int)c.getARGB());
+
+        out.writeCompressedInt(images.size());
+        for (auto& image : images)
+        {
+            out.writeString(image.source);
+            out.writeCompressedInt(image.width);
+            out.writeCompressedInt(image.height);
+        }
+
+        out.writeCompressedInt(listRanges.size());
+        for (auto& r : listRanges)
+        {
+            out.writeCompressedInt(r.getStart());
+            out.writeCompressedInt(r.getEnd());
+        }
+
+        out.writeCompressedInt(links.size());
+        for (auto& l : links)
+        {
+            out.writeString(l.url);
+            out.writeCompressedInt(l.position.getStart());
+            out.writeCompressedInt(l.position.getEnd());
+        }
+
+        out.writeCompressedInt((int)anchors.size());
+        for (auto& a : anchors)
+        {
+            out.writeString(a.first);
+            out.writeCompressedInt(a.second);
+        }
+
+        out.writeCompressedInt(length);
+    }
+
+    // Creates the fonts of a document being loaded, the same way the view did while parsing
+    using FontFactory = std::function<Font(const String& face, float height, int styleFlags)>;
+
+    // Returns nullptr if the data is broken
+    static Ptr readFrom(InputStream& in, const FontFactory& makeFont)
+    {
+        Ptr doc = new HtmlDocument();
+
+        auto numOperations = in.readCompressedInt();
+        for (int i = 0; i < numOperations && !in.isExhausted(); i++)
+        {
+            auto type = (OperationType)in.readByte();
+            auto index = in.readCompressedInt();
+            auto position = in.readCompressedInt();
+            doc->operations.add({ type, index, position });
+        }
+
+        auto numTexts = in.readCompressedInt();
+        for (int i = 0; i < numTexts && !in.isExhausted(); i++)
+            doc->texts.add(in.readString());
+
+        auto numFonts = in.readCompressedInt();
+        for (int i = 0; i < numFonts && !in.isExhausted(); i++)
+        {
+            auto face = in.readString();
+            auto height = in.readFloat();
+            auto styleFlags = in.readCompressedInt();
+            doc->fonts.add(makeFont(face, height, styleFlags));
+            doc->fontFaces.add(face);
+        }
+
+        auto numColours = in.readCompressedInt();
+        for (int i = 0; i < numColours && !in.isExhausted(); i++)
+            doc->colours.add(Colour((uint32)in.readInt()));
+
+        auto numImages = in.readCompressedInt();
+        for (int i = 0; i < numImages && !in.isExhausted(); i++)
+        {
+            auto source = in.readString();
+            auto width = in.readCompressedInt();
+            auto height = in.readCompressedInt();
+            doc->images.add({ source, Image(), width, height });
+        }
+
+        auto numListRanges = in.readCompressedInt();
+        for (int i = 0; i < numListRanges && !in.isExhausted(); i++)
+        {
+            auto start = in.readCompressedInt();
+            doc->listRanges.add({ start, in.readCompressedInt() });
+        }
+
+        auto numLinks = in.readCompressedInt();
+        for (int i = 0; i < numLinks && !in.isExhausted(); i++)
+        {
+            auto url = in.readString();
+            auto start = in.readCompressedInt();
+            doc->links.add({ url, { start, in.readCompressedInt() } });
+        }
+
+        auto numAnchors = in.readCompressedInt();
+        for (int i = 0; i < numAnchors && !in.isExhausted(); i++)
+        {
+            auto name = in.readString();
+            doc->anchors[name] = in.readCompressedInt();
+        }
+
+        doc->length = in.readCompressedInt();
+
+        return doc->isValid() && doc->operations.size() == numOperations && doc->links.size() == numLinks ? doc : nullptr;
+    }
+
+private:
+    // Only GSiHtmlTextEdit builds documents, and only while nobody else holds a reference to them
+    friend class GSiHtmlTextEdit;
+
+    enum class OperationType : uint8
+    {
+        text,           // Insert texts[index] at the caret position
+        font,           // Set fonts[index] for the text that follows
+        colour,         // Set colours[index] for the text that follows
+        image,          // Place images[index] below the text laid out so far
+        listSnapshot    // Replace the text in listRanges[index] with a snapshot of it
+    };
+
+    struct Operation
+    {
+        OperationType type;
+        int index;
+        int position;
+    };
+
+    struct EmbeddedImage
+    {
+        String source;
+        Image image;    // May be released by GSiHtmlTextEdit::trimMemory(), then it's loaded again from the source
+        int width, height;
+    };
+
+    Array<Operation> operations;
+    StringArray texts;
+    Array<Font> fonts;
+    Array<Colour> colours;
+    Array<EmbeddedImage> images;
+    Array<Range<int>> listRanges;
+    Array<Link> links;
+    StringArray fontFaces;  // The face each font was made from, to make it again when loading
+
+    // A std::unordered_map rather than a HashMap, which can't be copied
+    struct StringHash { size_t operator() (const String& s) const noexcept { return (size_t)s.hashCode64(); } };
+    std::unordered_map<String, int, StringHash> anchors;
+    int length = 0;
+
+    // Every operation refers to something that exists
+    bool isValid() const
+    {
+        for (auto& op : operations)
+        {
+            int size = 0;
+
+            switch (op.type)
+            {
+                case OperationType::text:           size = texts.size(); break;
+                case OperationType::font:           size = fonts.size(); break;
+                case OperationType::colour:         size = colours.size(); break;
+                case OperationType::image:          size = images.size(); break;
+                case OperationType::listSnapshot:   size = listRanges.size(); break;
+                default:                            return false;
+            }
+
+            if (!isPositiveAndBelow(op.index, size) || op.position < 0)
+                return false;
+        }
+
+        return length >= 0;
+    }
+
+    // Used to make a private copy of a shared document before adding to it
+    HtmlDocument(const HtmlDocument&) = default;
+    HtmlDocument& operator= (const HtmlDocument&) = delete;
+
+    JUCE_LEAK_DETECTOR(HtmlDocument)
+};
+
+//==============================================================================
+// Parsed documents by name, shared by everything in the process that uses it through
+// a SharedResourcePointer<HtmlDocumentCache> (e.g. all the instances of a plugin)
+class HtmlDocumentCache
+{
+public:
+    HtmlDocumentCache() = default;
+
+    HtmlDocument::Ptr find(const String& name) const
+    {
+        const ScopedLock sl(lock);
+        return documents[name];
+    }
+
+    void add(const String& name, HtmlDocument::Ptr document)
+    {
+        const ScopedLock sl(lock);
+        releaseUnused();
+        documents.set(name, document);
+    }
+
+    // Forget the documents that no view is showing
+    void releaseUnused()
+    {
+        const ScopedLock sl(lock);
+
+        StringArray unused;
+        for (HashMap<String, HtmlDocument::Ptr>::Iterator i(documents); i.next();)
+            if (i.getValue() == nullptr || i.getValue()->getReferenceCount() == 1)
+                unused.add(i.getKey());
+
+        for (auto& name : unused)
+            documents.remove(name);
+    }
+
+private:
+    CriticalSection lock;
+    HashMap<String, HtmlDocument::Ptr> documents;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HtmlDocumentCache)
+};
+
+//==============================================================================
+// Parsed documents saved in a folder, one file per HTML file. A saved document is used only if
+// the HTML file has the same path, size and modification time, and was parsed by the same
+// version of the parser with the same settings (anything else that changes the document, like
+// the parser's limits, the stylesheet or the default font, summed up by the caller in one number). Files are
+// memory-mapped to be loaded.
+class HtmlDocumentDiskCache
+{
+public:
+    HtmlDocumentDiskCache(const File& folderToUse, int64 maxTotalBytes = 64 * 1024 * 1024)
+        : folder(folderToUse), maxBytes(maxTotalBytes)
+    {
+    }
+
+    HtmlDocument::Ptr find(const File& source, int64 settings, const HtmlDocument::FontFactory& makeFont) const
+    {
+        auto file = getCacheFile(source, settings);
+        if (!file.existsAsFile()) return nullptr;
+
+        HtmlDocument::Ptr document;
+        {
+            MemoryMappedFile mapped(file, MemoryMappedFile::readOnly);
+            if (mapped.getData() == nullptr) return nullptr;
+
+            MemoryInputStream in(mapped.getData(), mapped.getSize(), false);
+            if (!readHeader(in, source, settings)) return nullptr;
+
+            document = HtmlDocument::readFrom(in, makeFont);
+        }
+
+        // Only once the file isn't mapped anymore, Windows can't delete it otherwise
+        if (document == nullptr) file.deleteFile();
+        else file.setLastModificationTime(Time::getCurrentTime()); // Marks it as recently used
+
+        return document;
+    }
+
+    bool store(const File& source, int64 settings, const HtmlDocument& document)
+    {
+        if (!folder.createDirectory()) return false;
+
+        // Written to a temporary file first, so that a crash never leaves a broken file behind
+        auto file = getCacheFile(source, settings);
+        TemporaryFile temp(file);
+        {
+            FileOutputStream out(temp.getFile());
+            if (!out.openedOk()) return false;
+
+            writeHeader(out, source, settings);
+            document.writeTo(out);
+            out.flush();
+            if (out.getStatus().failed()) return false;
+        }
+
+        if (!temp.overwriteTargetFileWithTemporary()) return false;
+
+        removeOldestFiles();
+        return true;
+    }
+
+    void clear()
+    {
+        for (auto& f : folder.findChildFiles(File::findFiles, false, "*" + String(fileExtension)))
+            f.deleteFile();
+    }
+
+private:
+    File folder;
+    int64 maxBytes;
+
+    static constexpr int magic = 0x44495347; // "GSID"
+    static constexpr const char* fileExtension = ".gsidoc";
+
+    File getCacheFile(const File& source, int64 settings) const
+    {
+        auto key = source.getFullPathName() + "|" + String(source.getSize()) + "|"
+                 + String(source.getLastModificationTime().toMilliseconds()) + "|" + String(HtmlDocument::formatVersion)
+                 + "|" + String(settings);
+
+        return folder.getChildFile(String::toHexString(key.hashCode64()) + fileExtension);
+    }
+
+    static void writeHeader(OutputStream& out, const File& source, int64 settings)
+    {
+        out.writeInt(magic);
+        out.writeInt(HtmlDocument::formatVersion);
+        out.writeInt64(settings);
+        out.writeString(source.getFullPathName());
+        out.writeInt64(source.getSize());
+        out.writeInt64(source.getLastModificationTime().toMilliseconds());
+    }
+
+    // The file name is only a hash, the header tells if it's really the same HTML file
+    static bool readHeader(InputStream& in, const File& source, int64 settings)
+    {
+        return in.readInt() == magic
+            && in.readInt() == HtmlDocument::formatVersion
+            && in.readInt64() == settings
+            && in.readString() == source.getFullPathName()
+            && in.readInt64() == source.getSize()
+            && in.readInt64() == source.getLastModificationTime().toMilliseconds();
+    }
+
+    // Keep the folder under its maximum size, the documents used least recently go first
+    void removeOldestFiles()
+    {
+        auto files = folder.findChildFiles(File::findFiles, false, "*" + String(fileExtension));
+
+        int64 total = 0;
+        for (auto& f : files)
+            total += f.getSize();
+
+        if (total <= maxBytes) return;
+
+        std::sort(files.begin(), files.end(), [](const File& a, const File& b)
+        {
+            return a.getLastModificationTime() < b.getLastModificationTime();
+        });
+
+        for (auto& f : files)
+        {
+            if (total <= maxBytes) break;
+            total -= f.getSize();
+            f.deleteFile();
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HtmlDocumentDiskCache)
+};
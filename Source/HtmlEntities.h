@@ -0,0 +1,42 @@
+/*
+  ==============================================================================
+
+    HtmlEntities.h
+    Created: 19 Oct 2026
+
+    The HTML entities known to GSiHtmlTextEdit (&amp; &lt; &#171; ...), in
+    one place so that everything reading a page, like HtmlSearchIndex, gets
+    the same characters as the view shows.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HtmlStringView.h"
+
+//==============================================================================
+struct HtmlEntities
+{
+    // The name goes between the '&' and the ';'. Returns 0 for an unknown entity, which isn't shown.
+    static juce_wchar decode(HtmlStringView name) noexcept
+    {
+        if (name.startsWith("#"))
+        {
+            auto c = HtmlStringView(name.start + 1, name.end).getIntValue();
+            return c > 0 && c <= 0x10ffff ? (juce_wchar)c : (juce_wchar)0xfffd;
+        }
+
+        if (name == "nbsp")     return ' ';     // Non-breakable space
+        if (name == "amp")      return '&';     // Ampersand
+        if (name == "quot")     return '"';     // Quotation mark
+        if (name == "lt")       return '<';
+        if (name == "gt")       return '>';
+        if (name == "rt")       return '>';     // Not HTML, but pages written for this view used it
+        if (name == "laquo")    return (juce_wchar)171;
+        if (name == "raquo")    return (juce_wchar)187;
+
+        return 0;
+    }
+};
@@ -0,0 +1,278 @@
+/*
+  ==============================================================================
+
+    HtmlFuzzer.h
+    Created: 19 Oct 2026
+
+    Headless fuzzing of GSiHtmlTextEdit, run from the command line:
+
+    HtmlTextEditor --fuzz [--runs <count>] [--seed <number>] [--size <bytes>]
+                          [--max-slowdown <factor>] [--max-memory <factor>]
+
+    Each run generates a synthetic document (see HtmlCorpusGenerator) and
+    breaks it in one way: unterminated comments, tags and entities, huge
+    images, deep nesting, random bytes, a cut in the middle... Both versions
+    are loaded, and the broken one mustn't take more time or allocate more
+    memory per input byte than --max-slowdown and --max-memory times the
+    clean one (10 by default), plus a little slack for the timer's noise.
+    That's what ParserLimits is for: a broken page can't hang the parser or
+    make it use much more memory than a correct one.
+    Before the runs, tags commented out (<!-- <pre> -->...) are checked to
+    leave the page exactly as if the comment wasn't there.
+    Results are printed as JSON, with the seed of each failed run so that
+    it can be run again alone (--seed <number> --runs 1). The exit code is
+    1 if any run failed. Memory is only checked when allocations are
+    counted, see AllocationCounter.h.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "GSiHtmlTextEdit.h"
+#include "HtmlCorpusGenerator.h"
+#include "AllocationCounter.h"
+
+//==============================================================================
+class HtmlFuzzer
+{
+public:
+    HtmlFuzzer() = default;
+
+    static bool isFuzzCommandLine(const String& commandLine)
+    {
+        return StringArray::fromTokens(commandLine, true).contains("--fuzz");
+    }
+
+    // Returns the application's exit code
+    int run(const String& commandLine)
+    {
+        auto args = StringArray::fromTokens(commandLine, true);
+        int runs = 100;
+        int64 seed = 1, size = 128 * 1024;
+        double maxSlowdown = 10.0, maxMemory = 10.0;
+
+        for (int i = 0; i < args.size(); i++)
+        {
+            auto arg = args[i].unquoted();
+            if (arg == "--runs" && i + 1 < args.size()) runs = jmax(1, args[++i].unquoted().getIntValue());
+            else if (arg == "--seed" && i + 1 < args.size()) seed = args[++i].unquoted().getLargeIntValue();
+            else if (arg == "--size" && i + 1 < args.size()) size = jmax((int64)1024, args[++i].unquoted().getLargeIntValue());
+            else if (arg == "--max-slowdown" && i + 1 < args.size()) maxSlowdown = jmax(1.0, args[++i].unquoted().getDoubleValue());
+            else if (arg == "--max-memory" && i + 1 < args.size()) maxMemory = jmax(1.0, args[++i].unquoted().getDoubleValue());
+        }
+
+        GSiHtmlTextEdit view;
+        view.setSize(800, 600);
+
+        Array<var> failures;
+        double worstSlowdown = 0.0, worstMemory = 0.0;
+
+        for (auto& tag : findTagsHandledInComments(view))
+        {
+            DynamicObject::Ptr failure = new DynamicObject();
+            failure->setProperty("check", "tagInComment");
+            failure->setProperty("tag", tag);
+            failures.add(var(failure.get()));
+        }
+
+        for (int i = 0; i < runs; i++)
+        {
+            auto runSeed = seed + i;
+            Random random(runSeed);
+
+            HtmlCorpusGenerator::Options options;
+            options.targetSize = size;
+            options.seed = runSeed;
+
+            auto cleanText = HtmlCorpusGenerator::generate(options);
+            MemoryBlock clean(cleanText.toRawUTF8(), cleanText.getNumBytesAsUTF8());
+
+            auto mutation = (Mutation)random.nextInt(numMutations);
+            auto broken = breakDocument(clean, mutation, random);
+
+            auto cleanCost = load(view, clean);
+            auto brokenCost = load(view, broken);
+
+            // Everything per input byte, the broken document can be much bigger or smaller than the clean one
+            auto cleanBytes = (double)jmax((size_t)1, clean.getSize());
+            auto brokenBytes = (double)jmax((size_t)1, broken.getSize());
+
+            auto slowdown = (brokenCost.ms / brokenBytes) / jmax(1.0e-9, cleanCost.ms / cleanBytes);
+            auto allowedMs = maxSlowdown * cleanCost.ms / cleanBytes * brokenBytes + timeSlackMs;
+            worstSlowdown = jmax(worstSlowdown, slowdown);
+
+            auto memory = ((double)brokenCost.bytes / brokenBytes) / jmax(1.0e-9, (double)cleanCost.bytes / cleanBytes);
+            auto allowedBytes = maxMemory * (double)cleanCost.bytes / cleanBytes * brokenBytes + (double)memorySlackBytes;
+            if (AllocationCounter::isEnabled()) worstMemory = jmax(worstMemory, memory);
+
+            bool tooSlow = brokenCost.ms > allowedMs;
+            bool tooBig = AllocationCounter::isEnabled() && (double)brokenCost.bytes > allowedBytes;
+
+            if (tooSlow || tooBig)
+            {
+                DynamicObject::Ptr failure = new DynamicObject();
+                failure->setProperty("seed", runSeed);
+                failure->setProperty("mutation", getMutationName(mutation));
+                failure->setProperty("inputBytes", (int64)broken.getSize());
+                failure->setProperty("ms", brokenCost.ms);
+                failure->setProperty("allowedMs", allowedMs);
+                failure->setProperty("allocatedBytes", AllocationCounter::isEnabled() ? var(brokenCost.bytes) : var(-1));
+                failure->setProperty("allowedBytes", AllocationCounter::isEnabled() ? var((int64)allowedBytes) : var(-1));
+                failures.add(var(failure.get()));
+            }
+        }
+
+        DynamicObject::Ptr root = new DynamicObject();
+        root->setProperty("runs", runs);
+        root->setProperty("seed", seed);
+        root->setProperty("size", size);
+        root->setProperty("allocationsCounted", AllocationCounter::isEnabled());
+        root->setProperty("worstSlowdown", worstSlowdown);
+        root->setProperty("worstMemory", AllocationCounter::isEnabled() ? var(worstMemory) : var(-1));
+        root->setProperty("failures", failures);
+
+        std::cout << JSON::toString(var(root.get())).toStdString() << std::endl;
+        return failures.isEmpty() ? 0 : 1;
+    }
+
+private:
+    static constexpr double timeSlackMs = 20.0;
+    static constexpr int64 memorySlackBytes = 1024 * 1024;
+
+    struct Cost
+    {
+        double ms;
+        int64 bytes;
+    };
+
+    static Cost load(GSiHtmlTextEdit& view, const MemoryBlock& html)
+    {
+        view.Reset(true);
+
+        auto bytesBefore = AllocationCounter::getNumBytes();
+        auto start = Time::getHighResolutionTicks();
+
+        view.appendHtml(static_cast<const char*>(html.getData()), html.getSize());
+
+        return { Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start) * 1000.0,
+                 AllocationCounter::getNumBytes() - bytesBefore };
+    }
+
+    // The tags that change the page even though they are in a comment, there should be none
+    static StringArray findTagsHandledInComments(GSiHtmlTextEdit& view)
+    {
+        const String before = "<p>Before <b>bold</b></p>", after = "<p>After <i>italic</i></p>";
+        auto clean = getDocumentData(view, before + after);
+
+        StringArray handled;
+        for (auto* tag : { "<pre>", "<h1>", "<img src=\"logo_GSi_680x219.png\">", "<a href=\"page2.htm\">", "<style>", "<ul><li>", "<font size=\"7\">", "<p id=\"x\">" })
+            if (getDocumentData(view, before + "<!-- " + tag + " -->" + after) != clean)
+                handled.add(tag);
+
+        return handled;
+    }
+
+    static MemoryBlock getDocumentData(GSiHtmlTextEdit& view, const String& html)
+    {
+        view.Reset(true);
+        view.appendHtml(html.toRawUTF8(), html.getNumBytesAsUTF8());
+
+        MemoryOutputStream out;
+        view.getDocument()->writeTo(out);
+        return out.getMemoryBlock();
+    }
+
+    //==============================================================================
+    // Ways to break a document, each one aimed at one of the parser's limits
+
+    enum Mutation
+    {
+        unterminatedComment,
+        unterminatedTag,
+        unterminatedEntity,
+        hugeNumericEntity,
+        hugeImage,
+        deepNesting,
+        unclosedBlock,
+        manyOpenings,
+        randomBytes,
+        cutAnywhere,
+        numMutations
+    };
+
+    static String getMutationName(Mutation mutation)
+    {
+        switch (mutation)
+        {
+            case unterminatedComment:   return "unterminatedComment";
+            case unterminatedTag:       return "unterminatedTag";
+            case unterminatedEntity:    return "unterminatedEntity";
+            case hugeNumericEntity:     return "hugeNumericEntity";
+            case hugeImage:             return "hugeImage";
+            case deepNesting:           return "deepNesting";
+            case unclosedBlock:         return "unclosedBlock";
+            case manyOpenings:          return "manyOpenings";
+            case randomBytes:           return "randomBytes";
+            case cutAnywhere:           return "cutAnywhere";
+            default:                    return {};
+        }
+    }
+
+    static MemoryBlock breakDocument(const MemoryBlock& clean, Mutation mutation, Random& random)
+    {
+        auto* data = static_cast<const char*>(clean.getData());
+        auto size = clean.getSize();
+        auto at = (size_t)random.nextInt((int)jmax((size_t)1, size));
+
+        MemoryOutputStream out;
+
+        auto insert = [&](const String& text)
+        {
+            out.write(data, at);
+            out << text;
+            out.write(data + at, size - at);
+        };
+
+        auto repeat = [](const String& text, int count)
+        {
+            String result;
+            result.preallocateBytes((size_t)(text.getNumBytesAsUTF8() * (size_t)count));
+            for (int i = 0; i < count; i++) result << text;
+            return result;
+        };
+
+        switch (mutation)
+        {
+            case unterminatedComment:   insert("<!-- never closed <p>"); break;
+            case unterminatedTag:       insert("<a href=\"never closed"); break;
+            case unterminatedEntity:    insert("&nbsp"); break;
+            case hugeNumericEntity:     insert(repeat("&#99999999999999999999;", 1 + random.nextInt(1000))); break;
+            case hugeImage:             insert(repeat("<img src=\"logo_GSi_680x219.png\" width=\"999999999\">", 1 + random.nextInt(20))); break;
+            case deepNesting:           insert(repeat("<big><b><span><font size=\"9999\">", 1000 + random.nextInt(20000))); break;
+            case unclosedBlock:         insert(random.nextBool() ? "<pre>" : "<style>"); break;
+            case manyOpenings:          insert(repeat(random.nextBool() ? "<" : "&", 1000 + random.nextInt(100000))); break;
+
+            case randomBytes:
+            {
+                // Overwrite a piece of the document with anything, invalid UTF-8 included
+                MemoryBlock garbage(jmin(size - at, (size_t)1 + (size_t)random.nextInt(4096)));
+                random.fillBitsRandomly(garbage.getData(), garbage.getSize());
+
+                out.write(data, at);
+                out.write(garbage.getData(), garbage.getSize());
+                out.write(data + at + garbage.getSize(), size - at - garbage.getSize());
+                break;
+            }
+
+            case cutAnywhere:           out.write(data, at); break;
+            default:                    out.write(data, size); break;
+        }
+
+        return out.getMemoryBlock();
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HtmlFuzzer)
+};
@@ -0,0 +1,682 @@
+/*
+  ==============================================================================
+
+    HtmlResources.h
+    Created: 19 Oct 2026
+
+    Where pages, images and fonts come from. A resource provider finds a
+    resource by the name used in the HTML (e.g. "page1.htm", "logo.png",
+    "verdana.ttf"), providers can be chained so that the first one that has
+    a resource wins:
+
+        auto chain = new ChainedResourceProvider();
+        chain->add(new DirectoryResourceProvider(helpFolder));
+        chain->add(new BinaryDataResourceProvider());
+        SharedResourcePointer<HtmlResources>()->setProvider(chain);
+
+    HtmlResources is shared by all the views in the process, through a
+    SharedResourcePointer<HtmlResources>. It keeps the resources it fetched
+    in one cache, keyed by where they were found (so the same name in two
+    folders doesn't mix up), and fetches them on a background thread when
+    asked to do it asynchronously. By default it looks in BinaryData, then
+    in the current working directory, like the views always did.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HtmlStringView.h"
+#include "TraceRecorder.h"
+
+//==============================================================================
+// The data of a resource, which never changes once fetched
+class HtmlResource : public ReferenceCountedObject
+{
+public:
+    using Ptr = ReferenceCountedObjectPtr<HtmlResource>;
+
+    // Data that stays valid as long as the program runs (e.g. BinaryData), not copied
+    HtmlResource(const String& resourceLocation, const void* permanentData, size_t permanentSize)
+        : location(resourceLocation), data(permanentData), size(permanentSize), isPermanent(true)
+    {
+    }
+
+    HtmlResource(const String& resourceLocation, MemoryBlock&& dataToOwn)
+        : location(resourceLocation), ownedData(std::move(dataToOwn))
+    {
+        data = ownedData.getData();
+        size = ownedData.getSize();
+    }
+
+    const String location;
+
+    const char* getData() const noexcept        { return static_cast<const char*>(data); }
+    size_t getSize() const noexcept             { return size; }
+
+    // Whether the data stays valid after this object is deleted
+    bool hasPermanentData() const noexcept      { return isPermanent; }
+
+    // Memory taken by the copy of the data, permanent data doesn't count
+    size_t getMemorySize() const noexcept       { return ownedData.getSize(); }
+
+private:
+    MemoryBlock ownedData;
+    const void* data = nullptr;
+    size_t size = 0;
+    bool isPermanent = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HtmlResource)
+};
+
+//==============================================================================
+// Providers are called from any thread, they must be thread-safe
+class HtmlResourceProvider : public ReferenceCountedObject
+{
+public:
+    using Ptr = ReferenceCountedObjectPtr<HtmlResourceProvider>;
+
+    virtual ~HtmlResourceProvider() = default;
+
+    // Where the resource is, without reading it (e.g. a full path), or an empty string if this
+    // provider doesn't have it. It must be cheap, it's the key of the cache.
+    virtual String locate(const String& name) = 0;
+
+    // Read the resource, or return nullptr if it can't
+    virtual HtmlResource::Ptr fetch(const String& name) = 0;
+
+    // Whether fetch() only reads memory or local files, so it can be called from the message thread
+    virtual bool isLocal() const { return true; }
+
+    // What this provider can fetch without going over the network, nullptr if nothing
+    virtual Ptr getLocalProvider() { return isLocal() ? this : nullptr; }
+};
+
+//==============================================================================
+// BinaryData with compressed resources. Fonts and text compress well, so they can be added to
+// the project gzipped (gzip -9 -n verdana.ttf gives verdana.ttf.gz, i.e. "verdana_ttf_gz"): they
+// are found by their uncompressed name, and decompressed the first time they are asked for.
+// Decompressed data is kept until the program ends, like the rest of BinaryData.
+class CompressedBinaryData
+{
+public:
+    // Same as BinaryData::getNamedResource(), but also finds the compressed resources
+    static const char* getNamedResource(const char* resourceNameUTF8, int& numBytes)
+    {
+        numBytes = 0;
+        if (auto* data = BinaryData::getNamedResource(resourceNameUTF8, numBytes))
+            return data;
+
+        String name(resourceNameUTF8);
+        auto& instance = getInstance();
+        const ScopedLock sl(instance.lock);
+
+        if (!instance.decompressed.contains(name))
+        {
+            int compressedSize = 0;
+            auto* compressed = BinaryData::getNamedResource((name + "_gz").toRawUTF8(), compressedSize);
+            if (compressed == nullptr || compressedSize <= 0)
+            {
+                numBytes = 0;
+                return nullptr;
+            }
+
+            GSI_TRACE_SCOPE_DETAIL("decompressResource", name);
+
+            MemoryInputStream in(compressed, (size_t)compressedSize, false);
+            GZIPDecompressorInputStream gzip(&in, false, GZIPDecompressorInputStream::gzipFormat);
+
+            auto* block = new MemoryBlock();
+            gzip.readIntoMemoryBlock(*block);
+            instance.blocks.add(block);
+            instance.decompressed.set(name, block);
+        }
+
+        auto* block = instance.decompressed[name];
+        numBytes = (int)block->getSize();
+        return numBytes > 0 ? static_cast<const char*>(block->getData()) : nullptr;
+    }
+
+    // Memory taken by the resources decompressed so far
+    static size_t getDecompressedSize()
+    {
+        auto& instance = getInstance();
+        const ScopedLock sl(instance.lock);
+
+        size_t total = 0;
+        for (auto* block : instance.blocks)
+            total += block->getSize();
+
+        return total;
+    }
+
+private:
+    CriticalSection lock;
+    OwnedArray<MemoryBlock> blocks;
+    HashMap<String, MemoryBlock*> decompressed;
+
+    static CompressedBinaryData& getInstance()
+    {
+        static CompressedBinaryData instance;
+        return instance;
+    }
+};
+
+//==============================================================================
+// Resources embedded in the program. The name of a file in BinaryData is the file name with
+// its dots replaced by underscores and its dashes removed: "logo-small.png" is "logosmall_png".
+// Compressed resources are found too, see CompressedBinaryData.
+class BinaryDataResourceProvider : public HtmlResourceProvider
+{
+public:
+    BinaryDataResourceProvider() = default;
+
+    static String getResourceName(const String& name)
+    {
+        return name.fromLastOccurrenceOf("/", false, false).replace(".", "_").replace("-", "");
+    }
+
+    String locate(const String& name) override
+    {
+        int size = 0;
+        auto resourceName = getResourceName(name);
+        if (BinaryData::getNamedResource(resourceName.toRawUTF8(), size) != nullptr && size > 0)
+            return "binary:" + resourceName;
+
+        // Compressed resources are located without decompressing them
+        return BinaryData::getNamedResource((resourceName + "_gz").toRawUTF8(), size) != nullptr && size > 0 ? "binary:" + resourceName : String();
+    }
+
+    HtmlResource::Ptr fetch(const String& name) override
+    {
+        int size = 0;
+        auto resourceName = getResourceName(name);
+        auto* data = CompressedBinaryData::getNamedResource(resourceName.toRawUTF8(), size);
+        if (data == nullptr || size <= 0) return nullptr;
+
+        return new HtmlResource("binary:" + resourceName, data, (size_t)size);
+    }
+};
+
+//==============================================================================
+// Files in a folder, or in the current working directory at the time they are looked for
+class DirectoryResourceProvider : public HtmlResourceProvider
+{
+public:
+    DirectoryResourceProvider(const File& folderToUse = File()) : folder(folderToUse) {}
+
+    String locate(const String& name) override
+    {
+        auto file = getFile(name);
+        return file.existsAsFile() ? file.getFullPathName() : String();
+    }
+
+    HtmlResource::Ptr fetch(const String& name) override
+    {
+        auto file = getFile(name);
+
+        MemoryBlock data;
+        if (!file.existsAsFile() || !file.loadFileAsData(data) || data.getSize() == 0) return nullptr;
+
+        return new HtmlResource(file.getFullPathName(), std::move(data));
+    }
+
+private:
+    const File folder;
+
+    File getFile(const String& name) const
+    {
+        auto base = folder == File() ? File::getCurrentWorkingDirectory() : folder;
+        auto file = base.getChildFile(name);
+
+        // Names like "../../secret.txt" mustn't escape the folder
+        return file.isAChildOf(base) ? file : File();
+    }
+};
+
+//==============================================================================
+// Entries of a zip file, e.g. a whole help set in a single file. The names of the entries are
+// indexed once when the file is opened, and an entry is only decompressed when it's fetched.
+// The last few entries decompressed are kept, so that going back to a page is instant.
+class ZipResourceProvider : public HtmlResourceProvider
+{
+public:
+    ZipResourceProvider(const File& zipFileToUse, int numEntriesToKeep = 8)
+        : zipFile(zipFileToUse), zip(zipFileToUse), maxRecentEntries(numEntriesToKeep)
+    {
+        for (int i = 0; i < zip.getNumEntries(); i++)
+        {
+            auto* entry = zip.getEntry(i);
+            if (entry != nullptr && !entry->isSymbolicLink && !entry->filename.endsWithChar('/'))
+                entries.set(getKey(entry->filename), i);
+        }
+    }
+
+    int getNumEntries() const noexcept { return entries.size(); }
+    const File& getZipFile() const noexcept { return zipFile; }
+
+    // The names of the entries, as stored in the zip file
+    StringArray getEntryNames() const
+    {
+        StringArray names;
+        for (HashMap<String, int>::Iterator i(entries); i.next();)
+            names.add(zip.getEntry(i.getValue())->filename);
+
+        names.sort(true);
+        return names;
+    }
+
+    // index.htm or index.html if there's one, otherwise the first page in alphabetical order
+    String getStartPage() const
+    {
+        for (auto name : { "index.htm", "index.html" })
+            if (entries.contains(name))
+                return zip.getEntry(entries[name])->filename;
+
+        for (auto& name : getEntryNames())
+            if (name.endsWithIgnoreCase(".htm") || name.endsWithIgnoreCase(".html"))
+                return name;
+
+        return {};
+    }
+
+    String locate(const String& name) override
+    {
+        return entries.contains(getKey(name)) ? getLocation(name) : String();
+    }
+
+    HtmlResource::Ptr fetch(const String& name) override
+    {
+        auto key = getKey(name);
+        if (!entries.contains(key)) return nullptr;
+
+        {
+            const ScopedLock sl(lock);
+            for (int i = recentEntries.size(); --i >= 0;)
+            {
+                if (recentEntries.getUnchecked(i)->location == getLocation(name))
+                {
+                    recentEntries.move(i, recentEntries.size() - 1);
+                    return recentEntries.getUnchecked(recentEntries.size() - 1);
+                }
+            }
+        }
+
+        // Each stream reads the file on its own, so entries can be decompressed in parallel
+        std::unique_ptr<InputStream> stream(zip.createStreamForEntry(entries[key]));
+        if (stream == nullptr) return nullptr;
+
+        GSI_TRACE_SCOPE_DETAIL("decompressEntry", name);
+
+        MemoryBlock data;
+        stream->readIntoMemoryBlock(data);
+        HtmlResource::Ptr resource = new HtmlResource(getLocation(name), std::move(data));
+
+        const ScopedLock sl(lock);
+        recentEntries.add(resource);
+        while (recentEntries.size() > maxRecentEntries)
+            recentEntries.remove(0);
+
+        return resource;
+    }
+
+private:
+    const File zipFile;
+    ZipFile zip;
+    HashMap<String, int> entries;   // Never modified after the constructor, so it's read without locking
+    ReferenceCountedArray<HtmlResource> recentEntries;
+    const int maxRecentEntries;
+    CriticalSection lock;
+
+    // Names are case-insensitive, with forward slashes and without a leading "./"
+    static String getKey(const String& name)
+    {
+        auto key = name.replaceCharacter('\\', '/').toLowerCase();
+        while (key.startsWith("./")) key = key.substring(2);
+        return key.trimCharactersAtStart("/");
+    }
+
+    String getLocation(const String& name) const
+    {
+        return zipFile.getFullPathName() + "!" + getKey(name);
+    }
+};
+
+//==============================================================================
+// Resources served over HTTP, e.g. by a local daemon: the name is appended to the base URL.
+// locate() can't know if the server has a resource without asking it, so put this provider
+// last in a chain. It isn't local, so HtmlResources::fetchLocal() never asks the server.
+class HttpResourceProvider : public HtmlResourceProvider
+{
+public:
+    HttpResourceProvider(const URL& baseUrlToUse, int timeoutMs = 5000) : baseUrl(baseUrlToUse), timeout(timeoutMs) {}
+
+    String locate(const String& name) override
+    {
+        return name.containsAnyOf(":\\") || name.startsWith("/") ? String() : baseUrl.getChildURL(name).toString(false);
+    }
+
+    HtmlResource::Ptr fetch(const String& name) override
+    {
+        auto location = locate(name);
+        if (location.isEmpty()) return nullptr;
+
+        int statusCode = 0;
+        auto stream = URL(location).createInputStream(URL::InputStreamOptions(URL::ParameterHandling::inAddress)
+                                                          .withConnectionTimeoutMs(timeout)
+                                                          .withStatusCode(&statusCode));
+        if (stream == nullptr || statusCode != 200) return nullptr;
+
+        MemoryBlock data;
+        stream->readIntoMemoryBlock(data);
+        return data.getSize() > 0 ? new HtmlResource(location, std::move(data)) : nullptr;
+    }
+
+    bool isLocal() const override { return false; }
+
+private:
+    const URL baseUrl;
+    const int timeout;
+};
+
+//==============================================================================
+// Asks each provider in turn, the first one that has the resource wins
+class ChainedResourceProvider : public HtmlResourceProvider
+{
+public:
+    ChainedResourceProvider() = default;
+
+    // Add providers before the chain is used, it can't be changed afterwards
+    ChainedResourceProvider& add(HtmlResourceProvider::Ptr provider)
+    {
+        providers.add(provider);
+        return *this;
+    }
+
+    String locate(const String& name) override
+    {
+        for (auto& p : providers)
+        {
+            auto location = p->locate(name);
+            if (location.isNotEmpty()) return location;
+        }
+
+        return {};
+    }
+
+    HtmlResource::Ptr fetch(const String& name) override
+    {
+        for (auto& p : providers)
+            if (p->locate(name).isNotEmpty())
+                return p->fetch(name);
+
+        return nullptr;
+    }
+
+    bool isLocal() const override
+    {
+        for (auto& p : providers)
+            if (!p->isLocal()) return false;
+
+        return true;
+    }
+
+    HtmlResourceProvider::Ptr getLocalProvider() override
+    {
+        if (isLocal()) return this;
+
+        auto* local = new ChainedResourceProvider();
+        for (auto& p : providers)
+            if (auto localPart = p->getLocalProvider())
+                local->add(localPart);
+
+        return local;
+    }
+
+private:
+    ReferenceCountedArray<HtmlResourceProvider> providers;
+};
+
+//==============================================================================
+class HtmlResources
+{
+public:
+    HtmlResources()
+    {
+        auto chain = new ChainedResourceProvider();
+        chain->add(new BinaryDataResourceProvider());
+        chain->add(new DirectoryResourceProvider());
+        provider = localProvider = chain;
+    }
+
+    ~HtmlResources()
+    {
+        pool.removeAllJobs(true, 10000);
+    }
+
+    // Replaces where resources come from, and empties the cache
+    void setProvider(HtmlResourceProvider::Ptr newProvider)
+    {
+        jassert(newProvider != nullptr);
+
+        const ScopedLock sl(lock);
+        provider = newProvider;
+        localProvider = newProvider->getLocalProvider();
+        cache.clear();
+        cacheOrder.clear();
+        cachedBytes = 0;
+    }
+
+    HtmlResourceProvider::Ptr getProvider() const
+    {
+        const ScopedLock sl(lock);
+        return provider;
+    }
+
+    // Where a resource would be found, or an empty string
+    String locate(const String& name) const
+    {
+        return getProvider()->locate(name);
+    }
+
+    // Get a resource from the cache, or from the provider if it's not there yet. Blocks
+    // while the provider reads it, call it from the message thread only for local resources.
+    HtmlResource::Ptr fetch(const String& name)
+    {
+        GSI_TRACE_SCOPE_DETAIL("fetchResource", name);
+        return fetchFrom(getProvider(), name);
+    }
+
+    // Like fetch(), but only from the local providers, never over the network. For what has to be
+    // found while parsing or painting on the message thread, like fonts.
+    HtmlResource::Ptr fetchLocal(const String& name)
+    {
+        GSI_TRACE_SCOPE_DETAIL("fetchLocalResource", name);
+
+        auto currentProvider = getLocalProvider();
+        return currentProvider != nullptr ? fetchFrom(currentProvider, name) : nullptr;
+    }
+
+    // Fetch a resource on a background thread, the callback is called on the message thread
+    // with the resource or nullptr. Make sure that whatever the callback uses still exists,
+    // e.g. with a Component::SafePointer.
+    void fetchAsync(const String& name, std::function<void(HtmlResource::Ptr)> callback)
+    {
+        pool.addJob([this, name, callback]
+        {
+            auto resource = fetch(name);
+            MessageManager::callAsync([resource, callback] { callback(resource); });
+        });
+    }
+
+    // Like fetchAsync(), also loading the images of the page in the cache before calling back,
+    // so that parsing the page doesn't wait for them
+    void fetchPageAsync(const String& name, std::function<void(HtmlResource::Ptr)> callback)
+    {
+        pool.addJob([this, name, callback]
+        {
+            auto resource = fetch(name);
+
+            if (resource != nullptr)
+            {
+                HtmlStringView html(resource->getData(), resource->getData() + resource->getSize());
+
+                for (auto i = html.indexOfIgnoreCase("<img "); i >= 0; i = html.indexOfIgnoreCase("<img "))
+                {
+                    html.start += i + 5;
+                    auto tagEnd = html.start;
+                    while (tagEnd < html.end && *tagEnd != '>') tagEnd++;
+
+                    auto src = HtmlStringView(html.start, tagEnd).getAttribute("src");
+                    if (src.isNotEmpty())
+                        loadImage(src.toString());
+                }
+            }
+
+            MessageManager::callAsync([resource, callback] { callback(resource); });
+        });
+    }
+
+    // Images are decoded once, and kept in the ImageCache under the location they were found at
+    Image loadImage(const String& name)
+    {
+        return loadImageFrom(getProvider(), name);
+    }
+
+    // Like loadImage(), but never over the network: an image that isn't local is only returned if it
+    // has already been decoded (e.g. by fetchPageAsync()). For the message thread, see loadImageAsync().
+    Image loadLocalImage(const String& name)
+    {
+        auto location = locate(name);
+        if (location.isEmpty()) return {};
+
+        auto image = ImageCache::getFromHashCode(location.hashCode64());
+        if (image.isValid()) return image;
+
+        auto currentProvider = getLocalProvider();
+        return currentProvider != nullptr ? loadImageFrom(currentProvider, name) : Image();
+    }
+
+    // Load an image on a background thread, the callback is called on the message thread with the
+    // image, invalid if it couldn't be loaded. Same precautions as fetchAsync().
+    void loadImageAsync(const String& name, std::function<void(Image)> callback)
+    {
+        pool.addJob([this, name, callback]
+        {
+            auto image = loadImage(name);
+            MessageManager::callAsync([image, callback] { callback(image); });
+        });
+    }
+
+    //==============================================================================
+    // Resources are released when the cache grows above the limit, the oldest first
+    void setCacheLimit(size_t maxBytes)
+    {
+        const ScopedLock sl(lock);
+        cacheLimit = maxBytes;
+        trimCache();
+    }
+
+    size_t getCacheSize() const
+    {
+        const ScopedLock sl(lock);
+        return cachedBytes;
+    }
+
+    void clearCache()
+    {
+        const ScopedLock sl(lock);
+        cache.clear();
+        cacheOrder.clear();
+        cachedBytes = 0;
+    }
+
+private:
+    CriticalSection lock;
+    HtmlResourceProvider::Ptr provider, localProvider;
+    HashMap<String, HtmlResource::Ptr> cache;
+    StringArray cacheOrder;
+    size_t cachedBytes = 0, cacheLimit = 16 * 1024 * 1024;
+    ThreadPool pool { 2 };
+
+    HtmlResourceProvider::Ptr getLocalProvider() const
+    {
+        const ScopedLock sl(lock);
+        return localProvider;
+    }
+
+    Image loadImageFrom(HtmlResourceProvider::Ptr currentProvider, const String& name)
+    {
+        auto location = currentProvider->locate(name);
+        if (location.isEmpty()) return {};
+
+        auto hash = location.hashCode64();
+        auto image = ImageCache::getFromHashCode(hash);
+        if (image.isValid()) return image;
+
+        auto resource = fetchFrom(currentProvider, name);
+        if (resource == nullptr) return {};
+
+        image = ImageFileFormat::loadFrom(resource->getData(), resource->getSize());
+
+       #if JUCE_WINDOWS && JUCE_MAJOR_VERSION >= 8 && JUCE8_USE_SOFTWARE_RENDERER // JUCE 8.0.0 or later
+        image = SoftwareImageType().convert(image);
+       #endif
+
+        if (image.isValid())
+            ImageCache::addImageToCache(image, hash);
+
+        // The encoded data isn't needed anymore once decoded
+        removeFromCache(resource->location);
+        return image;
+    }
+
+    HtmlResource::Ptr fetchFrom(HtmlResourceProvider::Ptr currentProvider, const String& name)
+    {
+        auto location = currentProvider->locate(name);
+        if (location.isEmpty()) return nullptr;
+
+        {
+            const ScopedLock sl(lock);
+            if (cache.contains(location))
+                return cache[location];
+        }
+
+        auto resource = currentProvider->fetch(name);
+        if (resource != nullptr)
+            addToCache(resource);
+
+        return resource;
+    }
+
+    void addToCache(HtmlResource::Ptr resource)
+    {
+        const ScopedLock sl(lock);
+        if (cache.contains(resource->location)) return;
+
+        cache.set(resource->location, resource);
+        cacheOrder.add(resource->location);
+        cachedBytes += resource->getMemorySize();
+        trimCache();
+    }
+
+    void removeFromCache(const String& location)
+    {
+        const ScopedLock sl(lock);
+        if (!cache.contains(location)) return;
+
+        cachedBytes -= cache[location]->getMemorySize();
+        cache.remove(location);
+        cacheOrder.removeString(location);
+    }
+
+    // The resources in use keep their data until they are released, only the cache forgets them
+    void trimCache()
+    {
+        while (cachedBytes > cacheLimit && cacheOrder.size() > 1)
+            removeFromCache(cacheOrder[0]);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HtmlResources)
+};
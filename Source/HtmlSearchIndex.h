@@ -0,0 +1,483 @@
+/*
+  ==============================================================================
+
+    HtmlSearchIndex.h
+    Created: 19 Oct 2026
+
+    Full-text search across a whole set of pages (e.g. all the help pages in
+    BinaryData), where GSiHtmlTextEdit::searchAndHighlight() only searches
+    the page being shown.
+
+    An inverted index maps each word to the pages containing it and how many
+    times, so a query only looks at the pages of its own words. Pages are
+    indexed in parallel on the shared HtmlThreadPool, so build() must not be
+    called from one of its jobs. The index can be saved and loaded back,
+    with a signature of the pages' contents to tell if it's still valid.
+    Entities are decoded like the view does (see HtmlEntities.h). Results are ranked
+    with BM25, words in the title of a page count more. A page must contain
+    all the words of the query to be found.
+
+    The index is shared by everything that uses it through a
+    SharedResourcePointer<HtmlSearchIndex>, all the methods are thread-safe.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HtmlStringView.h"
+#include "HtmlEntities.h"
+#include "HtmlThreadPool.h"
+
+//==============================================================================
+class HtmlSearchIndex
+{
+public:
+    HtmlSearchIndex() = default;
+
+    // A page to index, the data must stay valid while build() runs
+    struct Source
+    {
+        String name;
+        const char* data;
+        size_t size;
+    };
+
+    struct Result
+    {
+        String page;        // The name of the page, as given to build()
+        String title;       // From the <title> or the first header, or the name of the page
+        String snippet;     // Some text around the first match
+        String highlight;   // What to look for with GSiHtmlTextEdit::searchAndHighlight() once the page is shown
+        float score;
+    };
+
+    // Index the pages, replacing anything indexed before
+    void build(const Array<Source>& sources, int numThreads = SystemStats::getNumCpus())
+    {
+        auto startTime = Time::getMillisecondCounterHiRes();
+
+        // Each page is parsed and counted on its own, in parallel
+        OwnedArray<PageTerms> pageTerms;
+        for (int i = 0; i < sources.size(); i++)
+            pageTerms.add(new PageTerms());
+
+        {
+            SharedResourcePointer<HtmlThreadPool> pool;
+            HtmlJobBatch batch(*pool);
+
+            for (int i = 0; i < sources.size(); i++)
+            {
+                auto& source = sources.getReference(i);
+                auto* terms = pageTerms[i];
+
+                batch.waitUntilAtMost(jmax(1, numThreads) - 1);
+                batch.add([&source, terms] { terms->index(source); });
+            }
+
+            batch.waitForAll();
+        }
+
+        // Then merged in page order, so that the postings of each word are sorted by page
+        const ScopedLock sl(lock);
+        clear();
+
+        for (int i = 0; i < sources.size(); i++)
+        {
+            auto& terms = *pageTerms[i];
+            pages.add({ sources.getReference(i).name, terms.title, terms.text, terms.numWords });
+            totalWords += terms.numWords;
+
+            for (HashMap<String, int>::Iterator t(terms.counts); t.next();)
+                addPosting(t.getKey(), { i, t.getValue() });
+        }
+
+        signature = getSignature(sources);
+        DBG("HtmlSearchIndex: " << pages.size() << " pages, " << postings.size() << " words indexed in "
+            << String(Time::getMillisecondCounterHiRes() - startTime, 1) << " ms");
+    }
+
+    // Pages matching all the words of the query, the best first
+    Array<Result> search(const String& query, int maxResults = 20) const
+    {
+        const ScopedLock sl(lock);
+        Array<Result> results;
+
+        StringArray words;
+        tokenize(query, [&words](const String& word) { words.addIfNotAlreadyThere(word); });
+        if (words.isEmpty() || pages.isEmpty()) return results;
+
+        // Rarest words first, the intersection is only as big as their postings
+        Array<const Array<Posting>*> lists;
+        for (auto& word : words)
+        {
+            if (!termIds.contains(word)) return results;
+            lists.add(&postings.getReference(termIds[word]));
+        }
+
+        std::sort(lists.begin(), lists.end(), [](const Array<Posting>* a, const Array<Posting>* b) { return a->size() < b->size(); });
+
+        auto numPages = (float)pages.size();
+        auto averageWords = (float)totalWords / numPages;
+        HashMap<int, float> scores;
+
+        for (int l = 0; l < lists.size(); l++)
+        {
+            auto& list = *lists.getUnchecked(l);
+            auto idf = std::log(1.f + (numPages - (float)list.size() + 0.5f) / ((float)list.size() + 0.5f));
+            HashMap<int, float> matching;
+
+            for (auto& posting : list)
+            {
+                if (l > 0 && !scores.contains(posting.page)) continue;
+
+                // BM25, with k1 = 1.2 and b = 0.75
+                auto length = (float)pages.getReference(posting.page).numWords / jmax(1.f, averageWords);
+                auto tf = (float)posting.count;
+                auto score = idf * tf * 2.2f / (tf + 1.2f * (0.25f + 0.75f * length));
+
+                matching.set(posting.page, (l > 0 ? scores[posting.page] : 0.f) + score);
+            }
+
+            scores.swapWith(matching);
+            if (scores.size() == 0) return results;
+        }
+
+        // The whole query if the page has it as it is, otherwise its rarest word
+        auto rarestWord = words[0];
+        for (auto& word : words)
+            if (postings.getReference(termIds[word]).size() < postings.getReference(termIds[rarestWord]).size())
+                rarestWord = word;
+
+        for (HashMap<int, float>::Iterator s(scores); s.next();)
+        {
+            auto& page = pages.getReference(s.getKey());
+            auto highlight = page.text.containsIgnoreCase(query.trim()) ? query.trim() : rarestWord;
+            results.add({ page.name, page.title, getSnippet(page.text, highlight), highlight, s.getValue() });
+        }
+
+        std::sort(results.begin(), results.end(), [](const Result& a, const Result& b)
+        {
+            return a.score != b.score ? a.score > b.score : a.page < b.page;
+        });
+
+        if (results.size() > maxResults)
+            results.removeRange(maxResults, results.size() - maxResults);
+
+        return results;
+    }
+
+    bool isEmpty() const                { const ScopedLock sl(lock); return pages.isEmpty(); }
+    int getNumPages() const             { const ScopedLock sl(lock); return pages.size(); }
+
+    // The signature of the pages now in the index, 0 if there are none
+    int64 getPagesSignature() const     { const ScopedLock sl(lock); return signature; }
+
+    // Identifies a set of pages by their names and contents, to tell if a saved index is out of date
+    static int64 getSignature(const Array<Source>& sources)
+    {
+        String description(formatVersion);
+        for (auto& source : sources)
+        {
+            // FNV-1a, a page edited without changing its size must still be indexed again
+            uint64 h = 14695981039346656037ull;
+            for (size_t i = 0; i < source.size; i++)
+                h = (h ^ (uint8)source.data[i]) * 1099511628211ull;
+
+            description << ';' << source.name << ':' << (int64)source.size << ':' << String::toHexString((int64)h);
+        }
+
+        return description.hashCode64();
+    }
+
+    //==============================================================================
+    // Saving and loading the index, so that it doesn't have to be built at each run
+
+    void writeTo(OutputStream& out) const
+    {
+        const ScopedLock sl(lock);
+
+        out.writeInt(formatVersion);
+        out.writeInt64(signature);
+        out.writeCompressedInt(pages.size());
+
+        for (auto& page : pages)
+        {
+            out.writeString(page.name);
+            out.writeString(page.title);
+            out.writeString(page.text);
+            out.writeCompressedInt(page.numWords);
+        }
+
+        out.writeCompressedInt(postings.size());
+
+        for (HashMap<String, int>::Iterator t(termIds); t.next();)
+        {
+            auto& list = postings.getReference(t.getValue());
+            out.writeString(t.getKey());
+            out.writeCompressedInt(list.size());
+
+            // Pages are stored as the difference from the previous one, they are sorted
+            int previousPage = 0;
+            for (auto& posting : list)
+            {
+                out.writeCompressedInt(posting.page - previousPage);
+                out.writeCompressedInt(posting.count);
+                previousPage = posting.page;
+            }
+        }
+    }
+
+    // Fails, leaving the index empty, if the data is broken or doesn't match the signature of the pages
+    bool readFrom(InputStream& in, int64 expectedSignature)
+    {
+        const ScopedLock sl(lock);
+        clear();
+
+        if (in.readInt() != formatVersion || in.readInt64() != expectedSignature)
+            return false;
+
+        auto numPages = in.readCompressedInt();
+        if (numPages < 0) return false;
+
+        for (int i = 0; i < numPages && !in.isExhausted(); i++)
+        {
+            IndexedPage page;
+            page.name = in.readString();
+            page.title = in.readString();
+            page.text = in.readString();
+            page.numWords = in.readCompressedInt();
+            pages.add(page);
+            totalWords += page.numWords;
+        }
+
+        auto numWords = in.readCompressedInt();
+
+        for (int i = 0; i < numWords && !in.isExhausted(); i++)
+        {
+            auto word = in.readString();
+            auto numPostings = in.readCompressedInt();
+            int page = 0;
+
+            for (int j = 0; j < numPostings; j++)
+            {
+                page += in.readCompressedInt();
+                auto count = in.readCompressedInt();
+
+                if (!isPositiveAndBelow(page, pages.size()))
+                {
+                    clear();
+                    return false;
+                }
+
+                addPosting(word, { page, count });
+            }
+        }
+
+        if (pages.size() != numPages || postings.size() != numWords)
+        {
+            clear();
+            return false;
+        }
+
+        signature = expectedSignature;
+        return true;
+    }
+
+    //==============================================================================
+    // Calls the function with each word of the text, in lower case. Words are made of letters and digits.
+    template <typename Function>
+    static void tokenize(const String& text, Function&& function)
+    {
+        auto p = text.getCharPointer();
+        auto wordStart = p;
+
+        for (;;)
+        {
+            auto current = p;
+            auto c = p.getAndAdvance();
+
+            if (!CharacterFunctions::isLetterOrDigit(c))
+            {
+                if (current != wordStart)
+                    function(String(wordStart, current).toLowerCase());
+
+                if (c == 0) break;
+                wordStart = p;
+            }
+        }
+    }
+
+private:
+    static constexpr int formatVersion = 2;
+    static constexpr int titleWeight = 5;   // A word in the title counts as this many in the text
+    static constexpr int maxEntityLength = 32;  // As GSiHtmlTextEdit::ParserLimits, a longer one is just text
+
+    struct Posting
+    {
+        int page;
+        int count;
+    };
+
+    struct IndexedPage
+    {
+        String name, title, text;
+        int numWords;
+    };
+
+    Array<IndexedPage> pages;
+    HashMap<String, int> termIds;
+    Array<Array<Posting>> postings;
+    int64 totalWords = 0;
+    int64 signature = 0;
+    CriticalSection lock;
+
+    void clear()
+    {
+        pages.clear();
+        termIds.clear();
+        postings.clear();
+        totalWords = 0;
+        signature = 0;
+    }
+
+    void addPosting(const String& word, Posting posting)
+    {
+        if (!termIds.contains(word))
+        {
+            termIds.set(word, postings.size());
+            postings.add({});
+        }
+
+        postings.getReference(termIds[word]).add(posting);
+    }
+
+    //==============================================================================
+    // The words of a single page, built on a worker thread
+    struct PageTerms
+    {
+        String title, text;
+        HashMap<String, int> counts;
+        int numWords = 0;
+
+        void index(const Source& source)
+        {
+            text = extractText(source, title);
+
+            tokenize(text, [this](const String& word) { counts.set(word, counts[word] + 1); numWords++; });
+            tokenize(title, [this](const String& word) { counts.set(word, counts[word] + titleWeight); });
+
+            if (title.isEmpty())
+                title = source.name;
+        }
+    };
+
+    // The text of a page as it's shown, without tags, scripts, styles and comments, white spaces collapsed.
+    // The title is taken from the <title> or the first header.
+    static String extractText(const Source& source, String& title)
+    {
+        MemoryOutputStream out;
+        auto* p = source.data;
+        auto* end = source.data + source.size;
+        int64 titleStart = -1;
+        bool lastWasSpace = true;
+
+        auto writeSpace = [&] { if (!lastWasSpace) out << ' '; lastWasSpace = true; };
+        auto skipPast = [&](const char* text)
+        {
+            auto i = HtmlStringView(p, end).indexOfIgnoreCase(text);
+            p = i < 0 ? end : p + i + (int)strlen(text);
+        };
+
+        if (source.size >= 3 && CharPointer_UTF8::isByteOrderMark(p))
+            p += 3;
+
+        while (p < end)
+        {
+            if (*p == '<')
+            {
+                auto* tagEnd = p + 1;
+                while (tagEnd < end && *tagEnd != '>') tagEnd++;
+
+                auto tag = HtmlStringView(p + 1, tagEnd);
+                auto name = tag.upToFirstSpace();
+                p = tagEnd < end ? tagEnd + 1 : end;
+
+                if (tag.startsWith("!--"))              { p = tag.start; skipPast("-->"); }
+                else if (name.equalsIgnoreCase("style"))  skipPast("</style>");
+                else if (name.equalsIgnoreCase("script")) skipPast("</script>");
+                else if (title.isEmpty() && isTitle(name))
+                {
+                    writeSpace();
+                    titleStart = out.getDataSize();
+                }
+                else if (titleStart >= 0 && name.startsWith("/") && isTitle({ name.start + 1, name.end }))
+                {
+                    title = String::fromUTF8((const char*)out.getData() + titleStart, (int)(out.getDataSize() - (size_t)titleStart)).trim();
+                    titleStart = -1;
+                }
+
+                // Tags separate words, except the ones that only change the style
+                if (!(name.equalsIgnoreCase("b") || name.equalsIgnoreCase("/b") || name.equalsIgnoreCase("i") || name.equalsIgnoreCase("/i")
+                      || name.equalsIgnoreCase("u") || name.equalsIgnoreCase("/u") || name.equalsIgnoreCase("font") || name.equalsIgnoreCase("/font")
+                      || name.equalsIgnoreCase("span") || name.equalsIgnoreCase("/span") || name.equalsIgnoreCase("a") || name.equalsIgnoreCase("/a")))
+                    writeSpace();
+            }
+            else if (*p == '&')
+            {
+                auto* codeEnd = p + 1;
+                while (codeEnd < end && codeEnd - (p + 1) <= maxEntityLength && *codeEnd != ';') codeEnd++;
+
+                if (codeEnd < end && *codeEnd == ';')
+                {
+                    auto c = HtmlEntities::decode(HtmlStringView(p + 1, codeEnd));
+
+                    if (c == ' ') writeSpace();
+                    else if (c != 0) { out.appendUTF8Char(c); lastWasSpace = false; }
+
+                    p = codeEnd + 1;
+                }
+                else
+                {
+                    out << '&';
+                    lastWasSpace = false;
+                    p++;
+                }
+            }
+            else if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+            {
+                writeSpace();
+                p++;
+            }
+            else
+            {
+                out.writeByte(*p++);
+                lastWasSpace = false;
+            }
+        }
+
+        if (titleStart >= 0)
+            title = String::fromUTF8((const char*)out.getData() + titleStart, (int)(out.getDataSize() - (size_t)titleStart)).trim();
+
+        return String::fromUTF8((const char*)out.getData(), (int)out.getDataSize()).trim();
+    }
+
+    static bool isTitle(HtmlStringView name)
+    {
+        return name.equalsIgnoreCase("title") || name.equalsIgnoreCase("h1") || name.equalsIgnoreCase("h2")
+            || name.equalsIgnoreCase("h3") || name.equalsIgnoreCase("h4");
+    }
+
+    static String getSnippet(const String& text, const String& highlight)
+    {
+        constexpr int before = 40, length = 120;
+
+        auto start = jmax(0, text.indexOfIgnoreCase(highlight) - before);
+        auto snippet = text.substring(start, start + length).trim();
+
+        return (start > 0 ? "..." : "") + snippet + (start + length < text.length() ? "..." : "");
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HtmlSearchIndex)
+};
@@ -0,0 +1,227 @@
+/*
+  ==============================================================================
+
+    HtmlStringView.h
+    Created: 19 Oct 2026
+
+    A read-only view of a piece of a UTF-8 buffer, used by the parser to look
+    at tags, attributes, entities and CSS declarations in place instead of
+    copying them into Strings. The buffer must outlive the view. Searches and
+    comparisons are done on bytes, so the text to look for must be ASCII,
+    which is always the case for HTML and CSS names.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+struct HtmlStringView
+{
+    HtmlStringView() = default;
+    HtmlStringView(const char* s, const char* e) noexcept : start(s), end(e) {}
+    HtmlStringView(const char* asciiLiteral) noexcept : start(asciiLiteral), end(asciiLiteral + strlen(asciiLiteral)) {}
+
+    const char* start = nullptr;
+    const char* end = nullptr;
+
+    int length() const noexcept         { return (int)(end - start); }
+    bool isEmpty() const noexcept       { return start == end; }
+    bool isNotEmpty() const noexcept    { return start != end; }
+    void clear() noexcept               { start = end = nullptr; }
+
+    String toString() const             { return isEmpty() ? String() : String::fromUTF8(start, length()); }
+
+    char getLastCharacter() const noexcept { return isEmpty() ? 0 : end[-1]; }
+
+    //==============================================================================
+    bool operator== (const char* ascii) const noexcept
+    {
+        auto n = strlen(ascii);
+        return (size_t)length() == n && memcmp(start, ascii, n) == 0;
+    }
+
+    bool operator!= (const char* ascii) const noexcept { return !operator== (ascii); }
+
+    bool equalsIgnoreCase(const char* ascii) const noexcept
+    {
+        auto n = strlen(ascii);
+        return (size_t)length() == n && matchesIgnoreCase(start, ascii, n);
+    }
+
+    bool startsWith(const char* ascii) const noexcept
+    {
+        auto n = strlen(ascii);
+        return (size_t)length() >= n && memcmp(start, ascii, n) == 0;
+    }
+
+    bool startsWithIgnoreCase(const char* ascii) const noexcept
+    {
+        auto n = strlen(ascii);
+        return (size_t)length() >= n && matchesIgnoreCase(start, ascii, n);
+    }
+
+    bool endsWith(const char* ascii) const noexcept
+    {
+        auto n = strlen(ascii);
+        return (size_t)length() >= n && memcmp(end - n, ascii, n) == 0;
+    }
+
+    // Returns the byte offset of the text, or -1
+    int indexOfIgnoreCase(const char* ascii) const noexcept
+    {
+        auto n = strlen(ascii);
+        for (auto* p = start; p + n <= end; p++)
+            if (matchesIgnoreCase(p, ascii, n))
+                return (int)(p - start);
+
+        return -1;
+    }
+
+    bool containsIgnoreCase(const char* ascii) const noexcept { return indexOfIgnoreCase(ascii) >= 0; }
+
+    bool containsAnyOf(const char* asciiChars) const noexcept
+    {
+        for (auto* p = start; p < end; p++)
+            if (*p != 0 && strchr(asciiChars, *p) != nullptr)
+                return true;
+
+        return false;
+    }
+
+    //==============================================================================
+    HtmlStringView trim() const noexcept
+    {
+        auto s = start, e = end;
+        while (s < e && isSpace(*s)) s++;
+        while (e > s && isSpace(e[-1])) e--;
+        return { s, e };
+    }
+
+    // Splits at the first occurrence of a character outside single or double quotes.
+    // The part after it is empty when the character isn't found. rest may point to this view.
+    HtmlStringView upToFirstUnquoted(char c, HtmlStringView* rest = nullptr) const noexcept
+    {
+        HtmlStringView result(*this), after(end, end);
+        char quote = 0;
+
+        for (auto* p = start; p < end; p++)
+        {
+            if (quote != 0) { if (*p == quote) quote = 0; }
+            else if (*p == '"' || *p == '\'') quote = *p;
+            else if (*p == c)
+            {
+                result.end = p;
+                after.start = p + 1;
+                break;
+            }
+        }
+
+        if (rest != nullptr) *rest = after;
+        return result;
+    }
+
+    // Splits at the first space, tab or line break, e.g. to get the name of a tag from: img src="logo.png"
+    HtmlStringView upToFirstSpace(HtmlStringView* rest = nullptr) const noexcept
+    {
+        auto* p = start;
+        while (p < end && !isSpace(*p)) p++;
+
+        HtmlStringView result(start, p), after(p < end ? p + 1 : end, end);
+        if (rest != nullptr) *rest = after;
+        return result;
+    }
+
+    // The value of an attribute of a tag, e.g. getAttribute("src") on: img src="logo.png" width="200".
+    // Quotes are removed. Returns an empty view if the attribute isn't there.
+    HtmlStringView getAttribute(const char* name) const noexcept
+    {
+        auto n = strlen(name);
+
+        for (auto* p = start; p + n < end; p++)
+        {
+            if (p[n] != '=' || !matchesIgnoreCase(p, name, n)) continue;
+            if (p > start && !isSpace(p[-1])) continue; // Only whole names: "src" mustn't match "data-src"
+
+            auto* v = p + n + 1;
+            if (v < end && (*v == '"' || *v == '\''))
+            {
+                auto quote = *v++;
+                auto* e = v;
+                while (e < end && *e != quote) e++;
+                return { v, e };
+            }
+
+            auto* e = v;
+            while (e < end && !isSpace(*e)) e++;
+            return { v, e };
+        }
+
+        return {};
+    }
+
+    //==============================================================================
+    // Same rules as the String equivalents: leading spaces are skipped, parsing stops at the first invalid character
+
+    int getIntValue() const noexcept
+    {
+        auto* p = start;
+        while (p < end && isSpace(*p)) p++;
+
+        bool negative = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+')) p++;
+
+        // Saturates instead of overflowing on long runs of digits
+        int64 v = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; p++)
+            v = jmin((int64)std::numeric_limits<int>::max(), v * 10 + (*p - '0'));
+
+        return (int)(negative ? -v : v);
+    }
+
+    float getFloatValue() const noexcept
+    {
+        auto* p = start;
+        while (p < end && isSpace(*p)) p++;
+
+        bool negative = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+')) p++;
+
+        double v = 0.0, scale = 1.0;
+        for (; p < end && *p >= '0' && *p <= '9'; p++)
+            v = v * 10.0 + (*p - '0');
+
+        if (p < end && *p == '.')
+            for (p++; p < end && *p >= '0' && *p <= '9'; p++)
+                v += (*p - '0') * (scale *= 0.1);
+
+        return (float)(negative ? -v : v);
+    }
+
+    // Non-hex characters (like a leading '#') are ignored
+    uint32 getHexValue32() const noexcept
+    {
+        uint32 v = 0;
+        for (auto* p = start; p < end; p++)
+        {
+            auto digit = CharacterFunctions::getHexDigitValue((juce_wchar)(uint8)*p);
+            if (digit >= 0) v = (v << 4) | (uint32)digit;
+        }
+
+        return v;
+    }
+
+private:
+    static bool isSpace(char c) noexcept { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    static bool matchesIgnoreCase(const char* text, const char* ascii, size_t n) noexcept
+    {
+        for (size_t i = 0; i < n; i++)
+            if (CharacterFunctions::toLowerCase((juce_wchar)(uint8)text[i]) != CharacterFunctions::toLowerCase((juce_wchar)(uint8)ascii[i]))
+                return false;
+
+        return true;
+    }
+};
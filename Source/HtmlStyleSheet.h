@@ -0,0 +1,293 @@
+/*
+  ==============================================================================
+
+    HtmlStyleSheet.h
+    Created: 19 Oct 2026
+
+    CSS support for GSiHtmlTextEdit, limited to what a TextEditor can show:
+    font-family, font-size (px), font-weight: bold, font-style: italic,
+    text-decoration: underline and color.
+
+    HtmlStyle is a compiled block of declarations. HtmlStyleSheet compiles
+    rules with tag, .class and #id selectors (comma separated lists too)
+    into hash tables once, so that the style of an element is found with a
+    few lookups instead of parsing CSS again. Other selectors are ignored.
+    Rules come from <style> blocks in a page, or from a stylesheet shared by
+    all the pages with GSiHtmlTextEdit::setStyleSheet(), which mustn't be
+    modified anymore once it's in use.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HtmlStringView.h"
+
+//==============================================================================
+struct HtmlStyle
+{
+    enum Properties
+    {
+        hasFace = 1,
+        hasSize = 2,
+        hasColour = 4
+    };
+
+    int properties = 0;
+    String face;
+    float size = 0.f;
+    Colour colour;
+    int addedFlags = 0;     // Font::FontStyleFlags added to the ones already set
+
+    bool isEmpty() const noexcept { return properties == 0 && addedFlags == 0; }
+
+    // Compile declarations like: font-size: 20px; color: #FF0000
+    static HtmlStyle parse(HtmlStringView declarations)
+    {
+        HtmlStyle style;
+        auto remaining = declarations;
+
+        while (remaining.isNotEmpty())
+        {
+            auto declaration = remaining.upToFirstUnquoted(';', &remaining);
+
+            HtmlStringView valueAndRest;
+            auto key = declaration.upToFirstUnquoted(':', &valueAndRest).trim();
+            if (valueAndRest.isEmpty()) continue;
+            auto val = valueAndRest.upToFirstUnquoted(':').trim();
+
+            if (key == "text-decoration")
+            {
+                if (val.containsIgnoreCase("underline")) style.addedFlags |= Font::FontStyleFlags::underlined;
+            }
+            else if (key == "font-weight")
+            {
+                if (val.containsIgnoreCase("bold")) style.addedFlags |= Font::FontStyleFlags::bold;
+            }
+            else if (key == "font-style")
+            {
+                if (val.containsIgnoreCase("italic")) style.addedFlags |= Font::FontStyleFlags::italic;
+            }
+            else if (key == "font-size")
+            {
+                if (val.containsIgnoreCase("px"))
+                {
+                    style.size = (float)val.getIntValue();
+                    style.properties |= hasSize;
+                }
+            }
+            else if (key == "font-family")
+            {
+                style.face = val.toString().removeCharacters("'\"");
+                style.properties |= hasFace;
+            }
+            else if (key == "color")
+            {
+                // Names like "red", otherwise hex values, with or without the '#'
+                auto named = Colours::findColourForName(val.toString(), Colour());
+                style.colour = val.startsWith("#") || named == Colour() ? Colour(val.getHexValue32() + 0xFF000000) : named;
+                style.properties |= hasColour;
+            }
+        }
+
+        return style;
+    }
+
+    // Properties set in the other style win
+    void overrideWith(const HtmlStyle& other)
+    {
+        if (other.properties & hasFace)     face = other.face;
+        if (other.properties & hasSize)     size = other.size;
+        if (other.properties & hasColour)   colour = other.colour;
+        properties |= other.properties;
+        addedFlags |= other.addedFlags;
+    }
+
+    void applyTo(String& fontFace, float& fontSize, Colour& fontColor, int& fontStyle) const
+    {
+        if (properties & hasFace)       fontFace = face;
+        if (properties & hasSize)       fontSize = size;
+        if (properties & hasColour)     fontColor = colour;
+        fontStyle |= addedFlags;
+    }
+};
+
+//==============================================================================
+class HtmlStyleSheet : public ReferenceCountedObject
+{
+public:
+    using Ptr = ReferenceCountedObjectPtr<HtmlStyleSheet>;
+
+    HtmlStyleSheet() = default;
+
+    HtmlStyleSheet(const String& css)
+    {
+        addRules(css);
+    }
+
+    void addRules(const String& css)
+    {
+        auto* text = css.toRawUTF8();
+        addRules(HtmlStringView(text, text + css.getNumBytesAsUTF8()));
+    }
+
+    // Compile the rules of a stylesheet, later rules win over earlier ones with the same selector
+    void addRules(HtmlStringView css)
+    {
+        signature = signature * 31 + hash(css, false);
+        auto* p = css.start;
+
+        while (p < css.end)
+        {
+            auto* open = find(p, css.end, '{');
+            if (open == css.end) break;
+
+            auto* close = find(open + 1, css.end, '}');
+            auto style = HtmlStyle::parse(removeComments({ open + 1, close }));
+
+            auto selectors = removeComments({ p, open });
+            while (selectors.isNotEmpty())
+                addRule(selectors.upToFirstUnquoted(',', &selectors).trim(), style);
+
+            p = close + 1;
+        }
+    }
+
+    bool isEmpty() const noexcept
+    {
+        return tagRules.isEmpty() && classRules.isEmpty() && idRules.isEmpty();
+    }
+
+    void clear()
+    {
+        tagRules.clear(); classRules.clear(); idRules.clear();
+        tagIndex.clear(); classIndex.clear(); idIndex.clear();
+        signature = 0;
+    }
+
+    // Changes with every stylesheet added, to tell if a saved document was styled by the same rules
+    int64 getSignature() const noexcept
+    {
+        return signature;
+    }
+
+    // Add the rules that match an element to result, from the least to the most specific:
+    // tag, then each class (classes is the value of the class attribute), then id.
+    void resolve(HtmlStringView tagName, HtmlStringView classes, HtmlStringView id, HtmlStyle& result) const
+    {
+        if (auto* style = find(tagRules, tagIndex, tagName, true))
+            result.overrideWith(*style);
+
+        auto remaining = classes.trim();
+        while (remaining.isNotEmpty())
+        {
+            auto name = remaining.upToFirstSpace(&remaining);
+            if (auto* style = find(classRules, classIndex, name, false))
+                result.overrideWith(*style);
+            remaining = remaining.trim();
+        }
+
+        if (auto* style = find(idRules, idIndex, id.trim(), false))
+            result.overrideWith(*style);
+    }
+
+    //==============================================================================
+    // Hash of some text, tag names are case-insensitive but classes and ids aren't
+    static int64 hash(HtmlStringView text, bool ignoreCase) noexcept
+    {
+        uint64 h = 14695981039346656037ull;
+        for (auto* p = text.start; p < text.end; p++)
+        {
+            auto c = (uint8)*p;
+            if (ignoreCase && c >= 'A' && c <= 'Z') c = (uint8)(c + 32);
+            h = (h ^ c) * 1099511628211ull;
+        }
+        return (int64)h;
+    }
+
+private:
+    struct Rule
+    {
+        String selector;
+        HtmlStyle style;
+    };
+
+    Array<Rule> tagRules, classRules, idRules;
+    HashMap<int64, int> tagIndex, classIndex, idIndex;
+    int64 signature = 0;
+
+    void addRule(HtmlStringView selector, const HtmlStyle& style)
+    {
+        if (selector.isEmpty()) return;
+
+        if (selector.startsWith("."))       addRule(classRules, classIndex, { selector.start + 1, selector.end }, style, false);
+        else if (selector.startsWith("#"))  addRule(idRules, idIndex, { selector.start + 1, selector.end }, style, false);
+        else                                addRule(tagRules, tagIndex, selector, style, true);
+    }
+
+    static void addRule(Array<Rule>& rules, HashMap<int64, int>& index, HtmlStringView name, const HtmlStyle& style, bool ignoreCase)
+    {
+        // Only simple selectors are supported, skip things like "p.note", "ul li" or "a:hover"
+        if (name.isEmpty() || name.containsAnyOf(" \t\r\n.#:[>+~*")) return;
+
+        auto h = hash(name, ignoreCase);
+        if (index.contains(h))
+        {
+            rules.getReference(index[h]).style.overrideWith(style);
+            return;
+        }
+
+        index.set(h, rules.size());
+        rules.add({ name.toString(), style });
+    }
+
+    static const HtmlStyle* find(const Array<Rule>& rules, const HashMap<int64, int>& index, HtmlStringView name, bool ignoreCase)
+    {
+        if (name.isEmpty() || rules.isEmpty()) return nullptr;
+
+        auto h = hash(name, ignoreCase);
+        if (!index.contains(h)) return nullptr;
+
+        auto& rule = rules.getReference(index[h]);
+        auto* selector = rule.selector.toRawUTF8();
+        bool matches = ignoreCase ? name.equalsIgnoreCase(selector) : name == selector;
+        return matches ? &rule.style : nullptr;
+    }
+
+    static const char* find(const char* p, const char* end, char c) noexcept
+    {
+        while (p < end && *p != c) p++;
+        return p;
+    }
+
+    // Comments are only looked for between and inside rules, which is where they are in practice.
+    // The returned view is only valid until the next call.
+    HtmlStringView removeComments(HtmlStringView text)
+    {
+        if (text.indexOfIgnoreCase("/*") < 0) return text;
+
+        MemoryOutputStream out;
+        auto* p = text.start;
+
+        while (p < text.end)
+        {
+            auto commentStart = HtmlStringView(p, text.end).indexOfIgnoreCase("/*");
+            if (commentStart < 0) { out.write(p, (size_t)(text.end - p)); break; }
+
+            out.write(p, (size_t)commentStart);
+            out << ' ';
+
+            auto commentEnd = HtmlStringView(p + commentStart + 2, text.end).indexOfIgnoreCase("*/");
+            p = commentEnd < 0 ? text.end : p + commentStart + 2 + commentEnd + 2;
+        }
+
+        withoutComments = out.toString();
+        auto* s = withoutComments.toRawUTF8();
+        return { s, s + withoutComments.getNumBytesAsUTF8() };
+    }
+
+    String withoutComments;
+
+    JUCE_LEAK_DETECTOR(HtmlStyleSheet)
+};
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    HtmlThreadPool.h
+    Created: 19 Oct 2026
+
+    The thread pool shared by everything that works in the background, like
+    encoding rendered pages to PNG. Its threads are started when the first
+    user needs them and stopped when the last one goes away, use it through
+    a SharedResourcePointer<HtmlThreadPool>.
+
+    HtmlJobBatch adds jobs to a pool and waits for them without polling:
+    for all of them, or until only a few are left to keep the work that
+    piles up in check.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class HtmlThreadPool : public ThreadPool
+{
+public:
+    HtmlThreadPool() : ThreadPool(jmax(1, SystemStats::getNumCpus())) {}
+};
+
+//==============================================================================
+class HtmlJobBatch
+{
+public:
+    explicit HtmlJobBatch(ThreadPool& threadPool) : pool(threadPool) {}
+
+    // The jobs may use whatever the caller gave them, so they're always waited for
+    ~HtmlJobBatch()
+    {
+        waitForAll();
+    }
+
+    void add(std::function<void()> job)
+    {
+        ++state->numPending;
+
+        // The state is shared with the job, which still signals after the batch may have stopped waiting
+        pool.addJob([s = state, job = std::move(job)]
+        {
+            job();
+            --s->numPending;
+            s->jobFinished.signal();
+        });
+    }
+
+    // Blocks until no more than maxPending jobs are queued or running
+    void waitUntilAtMost(int maxPending)
+    {
+        while (state->numPending.load() > maxPending)
+            state->jobFinished.wait();
+    }
+
+    void waitForAll()
+    {
+        waitUntilAtMost(0);
+    }
+
+private:
+    struct State
+    {
+        std::atomic<int> numPending { 0 };
+        WaitableEvent jobFinished;
+    };
+
+    ThreadPool& pool;
+    std::shared_ptr<State> state = std::make_shared<State>();
+
+    JUCE_DECLARE_NON_COPYABLE(HtmlJobBatch)
+};
@@ -8,6 +8,31 @@
 
 #include <JuceHeader.h>
 #include "MainComponent.h"
+#include "HeadlessRenderer.h"
+#include "HtmlBenchmark.h"
+#include "HtmlFuzzer.h"
+
+//==============================================================================
+// Count heap allocations for the benchmark and the render statistics (see AllocationCounter.h)
+#if GSI_COUNT_ALLOCATIONS
+void* operator new (std::size_t size)
+{
+    AllocationCounter::add(size);
+
+    if (auto* p = std::malloc(size > 0 ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete (void* p) noexcept                 { std::free(p); }
+void operator delete (void* p, std::size_t) noexcept    { std::free(p); }
+
+static struct AllocationCounterSetup
+{
+    AllocationCounterSetup() { AllocationCounter::setEnabled(); }
+} allocationCounterSetup;
+#endif
 
 //==============================================================================
 class HtmlTextEditorApplication  : public juce::JUCEApplication
@@ -25,6 +50,30 @@ public:
     {
         // This method is where you should put your application's initialisation code..
 
+        // Batch mode: render pages to images and quit, without opening the main window
+        if (HeadlessRenderer::isBatchCommandLine(commandLine))
+        {
+            setApplicationReturnValue(HeadlessRenderer().run(commandLine));
+            quit();
+            return;
+        }
+
+        // Benchmark mode: print timings as JSON and quit
+        if (HtmlBenchmark::isBenchmarkCommandLine(commandLine))
+        {
+            setApplicationReturnValue(HtmlBenchmark().run(commandLine));
+            quit();
+            return;
+        }
+
+        // Fuzz mode: load broken pages, check that the parser stays within its limits and quit
+        if (HtmlFuzzer::isFuzzCommandLine(commandLine))
+        {
+            setApplicationReturnValue(HtmlFuzzer().run(commandLine));
+            quit();
+            return;
+        }
+
         mainWindow.reset (new MainWindow (getApplicationName()));
     }
 
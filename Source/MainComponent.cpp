@@ -5,15 +5,14 @@ MainComponent::MainComponent()
 {
     btnOpen.reset(new SquareButton("Open browser", 1));
     addAndMakeVisible(btnOpen.get());
-    btnOpen->onClickCallback = [&](const MouseEvent&) { browser->Show(); };
+    btnOpen->onClickCallback = [&](const MouseEvent&) { getBrowser().Show(); };
     btnOpen->centreWithSize(120, 30);
 
-    browser.reset(new SimpleHtmlBrowser());
-    addChildComponent(browser.get());
-
     setSize(1024, 768);
 
-    browser->Show();
+#if ! GSI_DEFER_HELP_BROWSER
+    getBrowser().Show();
+#endif
 }
 
 MainComponent::~MainComponent()
@@ -24,9 +23,47 @@ MainComponent::~MainComponent()
 void MainComponent::paint (juce::Graphics& g)
 {
     g.fillAll (Colours::black);
+
+#if GSI_DEFER_HELP_BROWSER
+    if (browser == nullptr)
+    {
+        // The window is on screen now, the browser can be created without delaying it
+        if (!browserCreationPending)
+        {
+            browserCreationPending = true;
+
+            Component::SafePointer<MainComponent> safeThis(this);
+            MessageManager::callAsync([safeThis]
+            {
+                if (safeThis != nullptr && safeThis->browser == nullptr)
+                    safeThis->getBrowser().Show();
+            });
+        }
+
+        g.setColour(Colours::grey);
+        g.drawText("Loading help...", getLocalBounds().withTop(btnOpen->getBottom() + 10).withHeight(30), Justification::centred);
+    }
+#endif
 }
 
 void MainComponent::resized()
 {
-    browser->setBounds(0, 0, getWidth(), getHeight());
+    if (browser != nullptr)
+        browser->setBounds(0, 0, getWidth(), getHeight());
+}
+
+// The browser is created the first time it's needed
+SimpleHtmlBrowser& MainComponent::getBrowser()
+{
+    if (browser == nullptr)
+    {
+        GSI_TRACE_SCOPE("createBrowser");
+
+        browser.reset(new SimpleHtmlBrowser());
+        addChildComponent(browser.get());
+        browser->setBounds(0, 0, getWidth(), getHeight());
+        repaint(); // Removes the placeholder
+    }
+
+    return *browser;
 }
@@ -4,6 +4,13 @@
 
 #include "HtmlBrowser.h"
 
+// Set to 1 to keep the help browser out of the application startup: the browser, its typefaces
+// and its first page are created once the window has been painted, or when it's opened if
+// that happens first. Meanwhile the window only shows a placeholder.
+#ifndef GSI_DEFER_HELP_BROWSER
+ #define GSI_DEFER_HELP_BROWSER 0
+#endif
+
 class MainComponent  : public juce::Component
 {
 public:
@@ -19,5 +26,9 @@ private:
     std::unique_ptr< SimpleHtmlBrowser> browser;
     std::unique_ptr<SquareButton> btnOpen;
 
+    bool browserCreationPending = false;
+
+    SimpleHtmlBrowser& getBrowser();
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
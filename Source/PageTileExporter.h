@@ -0,0 +1,194 @@
+/*
+  ==============================================================================
+
+    PageTileExporter.h
+    Created: 19 Oct 2026
+
+    Exports the page shown by a GSiHtmlTextEdit as a set of PNG tiles plus
+    a manifest.json that lists them, without blocking the message thread.
+    Tiles are rendered on the message thread a few at a time (rendering
+    components can't be done anywhere else) and compressed in parallel on
+    the shared HtmlThreadPool. Each compressed tile asks for the next ones
+    to be rendered, so nothing polls the pool. Progress is reported on the
+    message thread, and the export can be cancelled at any time.
+
+    Don't modify the page while the export is running.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "GSiHtmlTextEdit.h"
+#include "HtmlThreadPool.h"
+
+//==============================================================================
+class PageTileExporter : private AsyncUpdater
+{
+public:
+    PageTileExporter(GSiHtmlTextEdit& page, const File& destinationFolder, int tileHeightInPixels = 512, int numThreads = SystemStats::getNumCpus())
+        : view(&page), folder(destinationFolder), tileHeight(jmax(16, tileHeightInPixels)),
+          maxPendingTiles(jmax(1, numThreads) * 2)
+    {
+    }
+
+    ~PageTileExporter() override
+    {
+        cancel();
+    }
+
+    bool start()
+    {
+        if (view == nullptr || isRunning()) return false;
+
+        pageArea = view->getPageArea();
+        if (pageArea.isEmpty() || !folder.createDirectory()) return false;
+
+        // The exporter can be started again after it's finished or cancelled, once the last jobs have returned
+        encoders.waitForAll();
+        tiles.clear();
+        nextTileY = 0;
+        tilesDone = 0;
+        failed = false;
+        cancelled = false;
+
+        numTiles = (pageArea.getHeight() + tileHeight - 1) / tileHeight;
+        running = true;
+        triggerAsyncUpdate();
+        return true;
+    }
+
+    // Stops rendering and waits for the tiles already being compressed, the queued ones are skipped
+    void cancel()
+    {
+        running = false;
+        cancelled = true;
+        cancelPendingUpdate();
+        encoders.waitForAll();
+    }
+
+    bool isRunning() const
+    {
+        return running;
+    }
+
+    // Called on the message thread with a value between 0 and 1
+    std::function<void(double)> onProgress;
+
+    // Called on the message thread when all the tiles and the manifest have been written
+    std::function<void(bool success)> onFinished;
+
+private:
+    struct Tile
+    {
+        String fileName;
+        int y, height;
+    };
+
+    Component::SafePointer<GSiHtmlTextEdit> view;
+    File folder;
+    int tileHeight, maxPendingTiles;
+    Rectangle<int> pageArea;
+    int numTiles = 0, nextTileY = 0;
+    Array<Tile> tiles;
+    bool running = false;
+
+    std::atomic<int> tilesDone { 0 };
+    std::atomic<bool> failed { false }, cancelled { false };
+
+    // Declared last, so that its jobs are waited for before anything they use is destroyed
+    SharedResourcePointer<HtmlThreadPool> pool;
+    HtmlJobBatch encoders { *pool };
+
+    static constexpr double renderTimeSlice = 8.0;
+
+    // Called when the export starts and each time a tile has been compressed
+    void handleAsyncUpdate() override
+    {
+        if (!running) return;
+
+        if (view == nullptr)
+        {
+            cancel();
+            finish(false);
+            return;
+        }
+
+        // Render as many tiles as the time slice allows, unless the encoders are already busy enough
+        auto deadline = Time::getMillisecondCounterHiRes() + renderTimeSlice;
+
+        while (nextTileY < pageArea.getHeight() && getNumTilesInFlight() < maxPendingTiles
+               && Time::getMillisecondCounterHiRes() < deadline)
+        {
+            auto h = jmin(tileHeight, pageArea.getHeight() - nextTileY);
+            auto image = view->getPageTile(nextTileY, h);
+            auto file = folder.getChildFile("tile_" + String(tiles.size()).paddedLeft('0', 4) + ".png");
+            tiles.add({ file.getFileName(), nextTileY, h });
+            nextTileY += h;
+
+            encoders.add([this, image, file]
+            {
+                if (cancelled) return;
+
+                file.deleteFile();
+                FileOutputStream stream(file);
+                if (!stream.openedOk() || !PNGImageFormat().writeImageToStream(image, stream))
+                    failed = true;
+
+                tilesDone++;
+                triggerAsyncUpdate();
+            });
+        }
+
+        // Out of time with the encoders not full yet: go on once the other messages have been handled
+        if (nextTileY < pageArea.getHeight() && getNumTilesInFlight() < maxPendingTiles)
+            triggerAsyncUpdate();
+
+        if (onProgress != nullptr)
+            onProgress((double)tilesDone / (double)numTiles);
+
+        if (tilesDone == numTiles)
+        {
+            running = false;
+            finish(!failed && writeManifest());
+        }
+    }
+
+    // Rendered but not compressed yet. Counted here rather than by the batch, a job asks for more
+    // tiles before the batch knows it has finished.
+    int getNumTilesInFlight() const
+    {
+        return tiles.size() - tilesDone;
+    }
+
+    bool writeManifest()
+    {
+        Array<var> list;
+        for (auto& t : tiles)
+        {
+            DynamicObject::Ptr tile = new DynamicObject();
+            tile->setProperty("file", t.fileName);
+            tile->setProperty("y", t.y);
+            tile->setProperty("height", t.height);
+            list.add(var(tile.get()));
+        }
+
+        DynamicObject::Ptr manifest = new DynamicObject();
+        manifest->setProperty("width", pageArea.getWidth());
+        manifest->setProperty("height", pageArea.getHeight());
+        manifest->setProperty("tiles", list);
+
+        return folder.getChildFile("manifest.json").replaceWithText(JSON::toString(var(manifest.get())));
+    }
+
+    // This may delete the exporter, don't touch any member afterwards
+    void finish(bool success)
+    {
+        if (onFinished != nullptr)
+            onFinished(success);
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PageTileExporter)
+};
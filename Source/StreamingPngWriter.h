@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+    StreamingPngWriter.h
+    Created: 19 Oct 2026
+
+    Writes a PNG image to a stream a few rows at a time, so that a very tall
+    image (e.g. a whole rendered page) never needs to exist in memory at once.
+    Feed it horizontal tiles from top to bottom, then call finish().
+    The pixel data is compressed on the fly and written out as IDAT chunks
+    of a fixed size, so memory usage only depends on the tile size.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+class StreamingPngWriter
+{
+public:
+    StreamingPngWriter(OutputStream& destination, int imageWidth, int imageHeight)
+        : dest(destination), width(imageWidth), height(imageHeight), chunkStream(destination)
+    {
+        jassert(width > 0 && height > 0);
+
+        static const uint8 signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        dest.write(signature, sizeof(signature));
+
+        // 8 bit RGBA, no interlacing
+        MemoryOutputStream header;
+        header.writeIntBigEndian(width);
+        header.writeIntBigEndian(height);
+        header.writeByte(8);
+        header.writeByte(6);
+        header.writeByte(0);
+        header.writeByte(0);
+        header.writeByte(0);
+        writeChunk(dest, "IHDR", header.getData(), header.getDataSize());
+
+        rowBuffer.allocate((size_t)width * 4 + 1, true);
+        compressor.reset(new GZIPCompressorOutputStream(chunkStream));
+    }
+
+    ~StreamingPngWriter()
+    {
+        finish();
+    }
+
+    // Append the rows of a tile, which must be as wide as the image
+    bool writeRows(const Image& tile)
+    {
+        if (compressor == nullptr || tile.getWidth() != width) return false;
+
+        Image::BitmapData pixels(tile, Image::BitmapData::readOnly);
+        auto* row = rowBuffer.get();
+
+        for (int y = 0; y < tile.getHeight() && rowsWritten < height; y++)
+        {
+            // Store unpremultiplied RGBA, then apply the "Sub" filter which makes flat areas compress much better
+            for (int x = 0; x < width; x++)
+            {
+                auto c = pixels.getPixelColour(x, y);
+                auto* px = row + 1 + x * 4;
+                px[0] = c.getRed();
+                px[1] = c.getGreen();
+                px[2] = c.getBlue();
+                px[3] = c.getAlpha();
+            }
+
+            for (int i = width * 4; i > 4; i--)
+                row[i] = (uint8)(row[i] - row[i - 4]);
+
+            row[0] = 1; // Filter type: Sub
+            if (!compressor->write(row, (size_t)width * 4 + 1)) return false;
+            rowsWritten++;
+        }
+
+        return true;
+    }
+
+    // Complete the image (missing rows are left transparent), returns false if anything went wrong
+    bool finish()
+    {
+        if (compressor == nullptr) return !failed;
+
+        zeromem(rowBuffer.get(), (size_t)width * 4 + 1);
+        while (rowsWritten < height)
+        {
+            compressor->write(rowBuffer.get(), (size_t)width * 4 + 1);
+            rowsWritten++;
+        }
+
+        compressor.reset(); // Writes the end of the compressed stream
+        chunkStream.writePendingChunk();
+        writeChunk(dest, "IEND", nullptr, 0);
+        dest.flush();
+
+        failed = chunkStream.failed;
+        return !failed;
+    }
+
+private:
+    //==============================================================================
+    // Collects the compressed data and writes it out as IDAT chunks
+    class ChunkStream : public OutputStream
+    {
+    public:
+        ChunkStream(OutputStream& destination) : dest(destination) {}
+
+        bool write(const void* data, size_t numBytes) override
+        {
+            buffer.write(data, numBytes);
+            position += (int64)numBytes;
+
+            if (buffer.getDataSize() >= maxChunkSize)
+                writePendingChunk();
+
+            return !failed;
+        }
+
+        void writePendingChunk()
+        {
+            if (buffer.getDataSize() == 0) return;
+
+            if (!writeChunk(dest, "IDAT", buffer.getData(), buffer.getDataSize()))
+                failed = true;
+
+            buffer.reset();
+        }
+
+        void flush() override {}
+        bool setPosition(int64) override { return false; }
+        int64 getPosition() override { return position; }
+
+        bool failed = false;
+
+    private:
+        static constexpr size_t maxChunkSize = 65536;
+        OutputStream& dest;
+        MemoryOutputStream buffer;
+        int64 position = 0;
+    };
+
+    OutputStream& dest;
+    int width, height;
+    int rowsWritten = 0;
+    bool failed = false;
+    HeapBlock<uint8> rowBuffer;
+    ChunkStream chunkStream;
+    std::unique_ptr<GZIPCompressorOutputStream> compressor;
+
+    static bool writeChunk(OutputStream& out, const char* type, const void* data, size_t size)
+    {
+        auto crc = updateCrc(0xffffffff, type, 4);
+        if (size > 0) crc = updateCrc(crc, data, size);
+
+        return out.writeIntBigEndian((int)size)
+            && out.write(type, 4)
+            && (size == 0 || out.write(data, size))
+            && out.writeIntBigEndian((int)(crc ^ 0xffffffff));
+    }
+
+    static uint32 updateCrc(uint32 crc, const void* data, size_t size)
+    {
+        static const auto table = []
+        {
+            std::array<uint32, 256> t;
+            for (uint32 n = 0; n < 256; n++)
+            {
+                auto c = n;
+                for (int k = 0; k < 8; k++)
+                    c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+                t[n] = c;
+            }
+            return t;
+        }();
+
+        auto* bytes = static_cast<const uint8*>(data);
+        for (size_t i = 0; i < size; i++)
+            crc = table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+
+        return crc;
+    }
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StreamingPngWriter)
+};
@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    TraceRecorder.h
+    Created: 19 Oct 2026
+
+    Records timed scopes into per-thread buffers and writes them out as a
+    Chrome / Perfetto trace (open it in chrome://tracing or ui.perfetto.dev).
+
+    Put GSI_TRACE_SCOPE("name") or GSI_TRACE_SCOPE_DETAIL("name", someString)
+    at the beginning of a block to time it. While recording is off a scope
+    only costs the check of an atomic flag, and the detail expression isn't
+    even evaluated. Each thread writes to its own
+    buffer without locking, the buffers are only read by writeToFile().
+    Build with GSI_ENABLE_TRACING=0 to compile the scopes out entirely.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef GSI_ENABLE_TRACING
+ #define GSI_ENABLE_TRACING 1
+#endif
+
+//==============================================================================
+class TraceRecorder
+{
+public:
+    // Clears anything recorded so far and starts recording
+    static void start()
+    {
+        auto& r = getInstance();
+        r.generation++;
+        r.origin = Time::getHighResolutionTicks();
+        r.enabled = true;
+    }
+
+    static void stop()
+    {
+        getInstance().enabled = false;
+    }
+
+    static bool isRecording() noexcept
+    {
+        return getInstance().enabled.load(std::memory_order_relaxed);
+    }
+
+    // Write the events recorded since start() as a Chrome trace JSON file
+    static bool writeToFile(const File& file)
+    {
+        auto& r = getInstance();
+        auto ticksPerMicrosecond = (double)Time::getHighResolutionTicksPerSecond() / 1000000.0;
+        auto generation = r.generation.load();
+
+        MemoryOutputStream out;
+        out << "{\"traceEvents\":[\n";
+        bool first = true;
+
+        const SpinLock::ScopedLockType sl(r.buffersLock);
+
+        for (int t = 0; t < r.buffers.size(); t++)
+        {
+            auto* buffer = r.buffers.getUnchecked(t);
+            if (buffer->generation.load(std::memory_order_acquire) != generation) continue;
+
+            auto count = buffer->count.load(std::memory_order_acquire);
+
+            for (int i = 0; i < count; i++)
+            {
+                auto& e = buffer->events[i];
+
+                out << (first ? "" : ",\n")
+                    << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << t
+                    << ",\"name\":" << JSON::toString(var(String(e.name)))
+                    << ",\"ts\":" << String((double)(e.start - r.origin) / ticksPerMicrosecond, 3)
+                    << ",\"dur\":" << String((double)e.duration / ticksPerMicrosecond, 3);
+
+                if (e.detail[0] != 0)
+                    out << ",\"args\":{\"detail\":" << JSON::toString(var(String::fromUTF8(e.detail))) << "}";
+
+                out << "}";
+                first = false;
+            }
+
+            if (buffer->dropped > 0)
+                DBG("TraceRecorder: " << buffer->dropped.load() << " events dropped on thread " << t);
+        }
+
+        out << "\n]}\n";
+        return file.replaceWithData(out.getData(), out.getDataSize());
+    }
+
+    //==============================================================================
+    class Scope
+    {
+    public:
+        Scope(const char* scopeName) noexcept
+            : name(scopeName), start(isRecording() ? Time::getHighResolutionTicks() : 0)
+        {
+        }
+
+        bool isActive() const noexcept { return start != 0; }
+        void setDetail(const String& scopeDetail) { detail = scopeDetail; }
+
+        ~Scope()
+        {
+            if (start != 0)
+                record(name, detail, start, Time::getHighResolutionTicks());
+        }
+
+    private:
+        const char* name;
+        int64 start;
+        String detail;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+private:
+    struct Event
+    {
+        const char* name;
+        int64 start, duration;
+        char detail[40];
+    };
+
+    struct ThreadBuffer
+    {
+        static constexpr int capacity = 32768;
+        HeapBlock<Event> events { (size_t)capacity };
+        std::atomic<int> count { 0 }, generation { -1 }, dropped { 0 };
+    };
+
+    std::atomic<bool> enabled { false };
+    std::atomic<int> generation { 0 };
+    int64 origin = 0;
+
+    SpinLock buffersLock;
+    OwnedArray<ThreadBuffer> buffers; // Never deleted before the end of the program, threads keep pointers to them
+
+    static TraceRecorder& getInstance()
+    {
+        static TraceRecorder instance;
+        return instance;
+    }
+
+    static ThreadBuffer& getThreadBuffer()
+    {
+        static thread_local ThreadBuffer* buffer = nullptr;
+
+        if (buffer == nullptr)
+        {
+            auto& r = getInstance();
+            const SpinLock::ScopedLockType sl(r.buffersLock);
+            buffer = r.buffers.add(new ThreadBuffer());
+        }
+
+        return *buffer;
+    }
+
+    // Only the owning thread writes to its buffer, so no lock is needed here
+    static void record(const char* name, const String& detail, int64 start, int64 end)
+    {
+        auto& buffer = getThreadBuffer();
+        auto generation = getInstance().generation.load(std::memory_order_acquire);
+
+        if (buffer.generation.load(std::memory_order_relaxed) != generation)
+        {
+            buffer.count.store(0, std::memory_order_relaxed);
+            buffer.dropped = 0;
+            buffer.generation.store(generation, std::memory_order_release);
+        }
+
+        auto n = buffer.count.load(std::memory_order_relaxed);
+        if (n >= ThreadBuffer::capacity)
+        {
+            buffer.dropped++;
+            return;
+        }
+
+        auto& e = buffer.events[n];
+        e.name = name;
+        e.start = start;
+        e.duration = end - start;
+        e.detail[0] = 0;
+        if (detail.isNotEmpty())
+            detail.copyToUTF8(e.detail, sizeof(e.detail));
+
+        buffer.count.store(n + 1, std::memory_order_release);
+    }
+};
+
+//==============================================================================
+#if GSI_ENABLE_TRACING
+ #define GSI_TRACE_SCOPE(name)                  TraceRecorder::Scope JUCE_JOIN_MACRO(gsiTraceScope_, __LINE__) (name)
+ #define GSI_TRACE_SCOPE_DETAIL(name, detail)   TraceRecorder::Scope JUCE_JOIN_MACRO(gsiTraceScope_, __LINE__) (name); \
+                                                if (JUCE_JOIN_MACRO(gsiTraceScope_, __LINE__).isActive()) JUCE_JOIN_MACRO(gsiTraceScope_, __LINE__).setDetail(detail)
+#else
+ #define GSI_TRACE_SCOPE(name)
+ #define GSI_TRACE_SCOPE_DETAIL(name, detail)
+#endif